@@ -0,0 +1,799 @@
+// benchmarks for the doubly linked list
+//
+// Build and run with
+//     gcc -O2 -pthread -o dll_bench dll_bench.c && ./dll_bench [ops|sort|parallel|file|teardown|queue] [size] [csv|json]
+//
+// "ops" (the default) times every team_* operation one call at a time on
+// each storage backend, for teams of 10 players up to size (100000 by
+// default, 10000000 for the full sweep) in steps of ten, and prints
+// throughput and latency percentiles as csv or json. Seeds are fixed so
+// runs are comparable. Latencies include one clock read, so the cheapest
+// operations are dominated by it. "sort" compares team_sort against
+// copying the players out, qsorting them and pushing them onto a new team,
+// for teams of 1000 players up to size. "parallel" times the parallel
+// sort and reductions on a team of size players (1000000 by default) for
+// thread counts doubling up to every core. "file" compares rebuilding a
+// team of size players (1000000 by default) with team_push_back against
+// team_save and team_load through dll_bench.team in the current
+// directory, which is removed afterwards. "teardown" times free_team and
+// team_clear on plain and pooled teams of size players (1000000 by
+// default), and how long team_free_deferred keeps the caller. "queue"
+// runs the multi-threaded benchmarks with size players per thread instead.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "my_dll.h"
+#define MYDLL_CONCURRENT_IMPLEMENTATION
+#include "my_dll_concurrent.h"
+#include "my_dll_parallel.h"
+#include "my_dll_file.h"
+
+// Returns a monotonic timestamp in seconds.
+double nowSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Returns a monotonic timestamp in nanoseconds.
+long long nowNanos() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Operations the ops benchmark times.
+#define OP_CREATE_TEAM 0
+#define OP_PUSH_FRONT 1
+#define OP_PUSH_BACK 2
+#define OP_POP_FRONT 3
+#define OP_POP_BACK 4
+#define OP_INSERT 5
+#define OP_LIST_GET 6
+#define OP_LIST_REMOVE 7
+#define OP_FREE_TEAM 8
+#define OP_COUNT 9
+
+char* opNames[OP_COUNT] = {
+    "create_team", "team_push_front", "team_push_back", "team_pop_front",
+    "team_pop_back", "team_insert", "team_list_get", "team_list_remove",
+    "free_team"
+};
+
+// Storage backends the ops benchmark runs on.
+#define BACKEND_COUNT 5
+
+char* backendNames[BACKEND_COUNT] = {"linked", "pooled", "skiplist", "unrolled", "compact"};
+int backendFlags[BACKEND_COUNT] = {0, TEAM_POOLED, TEAM_SKIPLIST, TEAM_UNROLLED, TEAM_COMPACT};
+
+// Samples taken of one operation, fewer for the ones that walk the team
+// or rebuild it so the largest sizes still finish.
+#define OPS_SAMPLES 100000
+#define OPS_WALK_BUDGET 100000000LL
+#define OPS_FREE_BUDGET 10000000LL
+
+// One row of ops benchmark output.
+typedef struct opsResult {
+    char* backend;
+    char* op;
+    int size;
+    int threads;
+    int samples;
+    double opsPerSecond;
+    long long p50;		// latency percentiles in nanoseconds
+    long long p90;
+    long long p99;
+    long long max;
+} opsResult_t;
+
+// Returns the next number of a fixed xorshift sequence.
+unsigned int benchRandom(unsigned int* seed) {
+    unsigned int x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return x;
+}
+
+int compareNanos(const void* a, const void* b) {
+    long long x = *(const long long*)a;
+    long long y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+// Fills in the timing fields of result from the latencies of samples
+// calls, sorting them.
+void summarizeNanos(opsResult_t* result, long long* nanos, int samples) {
+    long long total = 0;
+    int i;
+    for (i = 0; i < samples; i++) {
+        total += nanos[i];
+    }
+    qsort(nanos, samples, sizeof(long long), compareNanos);
+
+    result->samples = samples;
+    result->opsPerSecond = total > 0 ? samples * 1e9 / total : 0;
+    result->p50 = nanos[samples / 2];
+    result->p90 = nanos[(int)(samples * 0.9)];
+    result->p99 = nanos[(int)(samples * 0.99)];
+    result->max = nanos[samples - 1];
+}
+
+// Returns a team made with flags holding size players.
+team_t* benchTeam(int flags, int size, unsigned int* seed) {
+    team_config_t config;
+    config.flags = flags;
+    team_t* t = create_team_with(&config);
+    char name[20] = "Pettersson";
+    int i;
+    for (i = 0; i < size; i++) {
+        team_push_back(t, benchRandom(seed) % 100, name);
+    }
+    return t;
+}
+
+// Times samples calls of op on a team made with flags holding size
+// players, undoing each call untimed so the size stays put, and fills in
+// result from the sorted latencies.
+void opsBenchmark(int backend, int op, int size, int samples, opsResult_t* result) {
+    unsigned int seed = 2463534242u ^ (unsigned int)(op * 7919 + size);
+    int flags = backendFlags[backend];
+    char name[20] = "Pettersson";
+    long long* nanos = (long long*)malloc(sizeof(long long) * samples);
+    team_t* t = op == OP_CREATE_TEAM || op == OP_FREE_TEAM ? NULL : benchTeam(flags, size, &seed);
+    team_config_t config;
+    config.flags = flags;
+
+    int i;
+    for (i = 0; i < samples; i++) {
+        int pos = size > 0 ? (int)(benchRandom(&seed) % size) : 0;
+        long long start, end;
+        player_t* p;
+        team_t* other;
+        switch (op) {
+        case OP_CREATE_TEAM:
+            start = nowNanos();
+            other = create_team_with(&config);
+            end = nowNanos();
+            free_team(other);
+            break;
+        case OP_PUSH_FRONT:
+            start = nowNanos();
+            team_push_front(t, i, name);
+            end = nowNanos();
+            free_player(team_pop_front(t));
+            break;
+        case OP_PUSH_BACK:
+            start = nowNanos();
+            team_push_back(t, i, name);
+            end = nowNanos();
+            free_player(team_pop_back(t));
+            break;
+        case OP_POP_FRONT:
+            start = nowNanos();
+            p = team_pop_front(t);
+            end = nowNanos();
+            free_player(p);
+            team_push_front(t, i, name);
+            break;
+        case OP_POP_BACK:
+            start = nowNanos();
+            p = team_pop_back(t);
+            end = nowNanos();
+            free_player(p);
+            team_push_back(t, i, name);
+            break;
+        case OP_INSERT:
+            start = nowNanos();
+            team_insert(t, pos, i, name);
+            end = nowNanos();
+            free_player(team_list_remove(t, pos));
+            break;
+        case OP_LIST_GET:
+            start = nowNanos();
+            team_list_get(t, pos);
+            end = nowNanos();
+            break;
+        case OP_LIST_REMOVE:
+            start = nowNanos();
+            p = team_list_remove(t, pos);
+            end = nowNanos();
+            free_player(p);
+            team_insert(t, pos, i, name);
+            break;
+        default:
+            other = benchTeam(flags, size, &seed);
+            start = nowNanos();
+            free_team(other);
+            end = nowNanos();
+            break;
+        }
+        nanos[i] = end - start;
+    }
+    free_team(t);
+
+    result->backend = backendNames[backend];
+    result->op = opNames[op];
+    result->size = op == OP_CREATE_TEAM ? 0 : size;
+    result->threads = 1;
+    summarizeNanos(result, nanos, samples);
+    free(nanos);
+}
+
+// Prints one ops benchmark row, the first and last rows also open and
+// close the output.
+void printResult(opsResult_t* r, int json, int first, int last) {
+    if (json) {
+        printf("%s  {\"backend\": \"%s\", \"op\": \"%s\", \"size\": %d, \"threads\": %d, \"samples\": %d, "
+               "\"ops_per_sec\": %.0f, \"p50_ns\": %lld, \"p90_ns\": %lld, \"p99_ns\": %lld, \"max_ns\": %lld}%s\n",
+               first ? "[\n" : "", r->backend, r->op, r->size, r->threads, r->samples,
+               r->opsPerSecond, r->p50, r->p90, r->p99, r->max, last ? "\n]" : ",");
+    }
+    else {
+        if (first) {
+            printf("backend,op,size,threads,samples,ops_per_sec,p50_ns,p90_ns,p99_ns,max_ns\n");
+        }
+        printf("%s,%s,%d,%d,%d,%.0f,%lld,%lld,%lld,%lld\n", r->backend, r->op, r->size, r->threads,
+               r->samples, r->opsPerSecond, r->p50, r->p90, r->p99, r->max);
+    }
+    fflush(stdout);
+}
+
+// Runs every operation on every backend for sizes 10 up to maxSize.
+void opsSuite(int maxSize, int json) {
+    int first = 1;
+    int backend, op, size;
+    opsResult_t result;
+    int havePending = 0;
+    opsResult_t pending;
+
+    for (backend = 0; backend < BACKEND_COUNT; backend++) {
+        for (op = 0; op < OP_COUNT; op++) {
+            for (size = 10; size <= maxSize; size *= 10) {
+                int samples = OPS_SAMPLES;
+                if (op == OP_INSERT || op == OP_LIST_GET || op == OP_LIST_REMOVE) {
+                    long long walk = OPS_WALK_BUDGET / size;
+                    samples = walk < samples ? (walk > 100 ? (int)walk : 100) : samples;
+                }
+                else if (op == OP_FREE_TEAM) {
+                    long long rebuild = OPS_FREE_BUDGET / size;
+                    samples = rebuild < 1000 ? (rebuild > 3 ? (int)rebuild : 3) : 1000;
+                }
+
+                opsBenchmark(backend, op, size, samples, &result);
+                // rows are printed one behind so the last one knows it is last
+                if (havePending) {
+                    printResult(&pending, json, first, 0);
+                    first = 0;
+                }
+                pending = result;
+                havePending = 1;
+
+                if (op == OP_CREATE_TEAM) {
+                    break;
+                }
+            }
+        }
+    }
+
+    if (havePending) {
+        printResult(&pending, json, first, 1);
+    }
+}
+
+// Shared state of one queue benchmark run: producers push at the back,
+// consumers pop at the front until every pushed player was popped.
+typedef struct queueRun {
+    team_t* team;			// plain team behind one global mutex, or NULL
+    pthread_mutex_t teamLock;
+    team_concurrent_t* concurrent;	// two-lock team, or NULL
+    team_lockfree_t* lockfree;		// lock-free team, or NULL
+    int opsPerThread;
+    int consumed;			// updated atomically
+    int total;
+} queueRun_t;
+
+void* queueProducer(void* arg) {
+    queueRun_t* run = (queueRun_t*)arg;
+    char name[20] = "Pettersson";
+    int i;
+    for (i = 0; i < run->opsPerThread; i++) {
+        if (run->team != NULL) {
+            pthread_mutex_lock(&run->teamLock);
+            team_push_back(run->team, i, name);
+            pthread_mutex_unlock(&run->teamLock);
+        }
+        else if (run->concurrent != NULL) {
+            team_concurrent_push_back(run->concurrent, i, name);
+        }
+        else {
+            team_lockfree_push_back(run->lockfree, i, name);
+        }
+    }
+    return NULL;
+}
+
+void* queueConsumer(void* arg) {
+    queueRun_t* run = (queueRun_t*)arg;
+    while (__atomic_load_n(&run->consumed, __ATOMIC_RELAXED) < run->total) {
+        player_t* p;
+        if (run->team != NULL) {
+            pthread_mutex_lock(&run->teamLock);
+            p = team_pop_front(run->team);
+            pthread_mutex_unlock(&run->teamLock);
+        }
+        else if (run->concurrent != NULL) {
+            p = team_concurrent_pop_front(run->concurrent);
+        }
+        else {
+            p = team_lockfree_pop_front(run->lockfree);
+        }
+        if (p != NULL) {
+            __atomic_fetch_add(&run->consumed, 1, __ATOMIC_RELAXED);
+            free_player(p);
+        }
+    }
+    return NULL;
+}
+
+// Queue flavours queueBenchmark can run.
+#define QUEUE_MUTEX 0		// plain team behind one global mutex
+#define QUEUE_TWO_LOCK 1	// team_concurrent_t
+#define QUEUE_LOCK_FREE 2	// team_lockfree_t
+
+// Runs threads/2 producers against threads/2 consumers, at least one of
+// each, and returns the millions of players moved through per second.
+double queueBenchmark(int flavour, int threads, int opsPerThread) {
+    queueRun_t run;
+    int producers = threads / 2 > 0 ? threads / 2 : 1;
+    int consumers = threads - producers > 0 ? threads - producers : 1;
+
+    run.team = flavour == QUEUE_MUTEX ? create_team() : NULL;
+    run.concurrent = flavour == QUEUE_TWO_LOCK ? create_team_concurrent() : NULL;
+    run.lockfree = flavour == QUEUE_LOCK_FREE ? create_team_lockfree() : NULL;
+    pthread_mutex_init(&run.teamLock, NULL);
+    run.opsPerThread = opsPerThread;
+    run.consumed = 0;
+    run.total = producers * opsPerThread;
+
+    pthread_t* ids = (pthread_t*)malloc(sizeof(pthread_t) * (producers + consumers));
+    double start = nowSeconds();
+    int i;
+    for (i = 0; i < producers; i++) {
+        pthread_create(&ids[i], NULL, queueProducer, &run);
+    }
+    for (i = 0; i < consumers; i++) {
+        pthread_create(&ids[producers + i], NULL, queueConsumer, &run);
+    }
+    for (i = 0; i < producers + consumers; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    double elapsed = nowSeconds() - start;
+
+    free(ids);
+    free_team(run.team);
+    free_team_concurrent(run.concurrent);
+    free_team_lockfree(run.lockfree);
+    pthread_mutex_destroy(&run.teamLock);
+
+    return run.total / elapsed / 1e6;
+}
+
+// Shared state of one work queue benchmark run: every worker pushes a
+// batch of work and pops a batch back, like a scheduler spawning tasks.
+typedef struct workRun {
+    team_t* team;			// plain team behind one global mutex, or NULL
+    pthread_mutex_t teamLock;
+    team_sharded_t* sharded;		// sharded team, or NULL
+    int opsPerThread;
+} workRun_t;
+
+// One worker of a work queue benchmark run.
+typedef struct workWorker {
+    workRun_t* run;
+    int self;
+} workWorker_t;
+
+#define WORK_BATCH 16
+
+void* workWorker(void* arg) {
+    workWorker_t* worker = (workWorker_t*)arg;
+    workRun_t* run = worker->run;
+    char name[20] = "Pettersson";
+    int i, j;
+    for (i = 0; i < run->opsPerThread; i += WORK_BATCH) {
+        for (j = 0; j < WORK_BATCH; j++) {
+            if (run->team != NULL) {
+                pthread_mutex_lock(&run->teamLock);
+                team_push_front(run->team, i + j, name);
+                pthread_mutex_unlock(&run->teamLock);
+            }
+            else {
+                team_sharded_push(run->sharded, worker->self, i + j, name);
+            }
+        }
+        for (j = 0; j < WORK_BATCH; j++) {
+            player_t* p;
+            if (run->team != NULL) {
+                pthread_mutex_lock(&run->teamLock);
+                p = team_pop_front(run->team);
+                pthread_mutex_unlock(&run->teamLock);
+            }
+            else {
+                p = team_sharded_pop(run->sharded, worker->self);
+            }
+            free_player(p);
+        }
+    }
+    return NULL;
+}
+
+// Runs threads workers on one mutex-wrapped team or on a team with a
+// shard per worker, and returns the millions of push and pop pairs per
+// second.
+double workBenchmark(int useSharded, int threads, int opsPerThread) {
+    workRun_t run;
+    run.team = useSharded ? NULL : create_team();
+    run.sharded = useSharded ? create_team_sharded(threads) : NULL;
+    pthread_mutex_init(&run.teamLock, NULL);
+    run.opsPerThread = opsPerThread;
+
+    pthread_t* ids = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+    workWorker_t* workers = (workWorker_t*)malloc(sizeof(workWorker_t) * threads);
+    double start = nowSeconds();
+    int i;
+    for (i = 0; i < threads; i++) {
+        workers[i].run = &run;
+        workers[i].self = i;
+        pthread_create(&ids[i], NULL, workWorker, &workers[i]);
+    }
+    for (i = 0; i < threads; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    double elapsed = nowSeconds() - start;
+
+    free(ids);
+    free(workers);
+    free_team(run.team);
+    free_team_sharded(run.sharded);
+    pthread_mutex_destroy(&run.teamLock);
+
+    return (double)threads * opsPerThread / elapsed / 1e6;
+}
+
+// Returns a team holding size players with random roster numbers and
+// random names.
+team_t* benchNamedTeam(int size, unsigned int* seed) {
+    team_t* t = create_team();
+    char name[20];
+    int i;
+    for (i = 0; i < size; i++) {
+        unsigned int r = benchRandom(seed);
+        sprintf(name, "player-%08x", r);
+        team_push_back(t, r % 1000000, name);
+    }
+    return t;
+}
+
+// One player copied out of a team for qsort.
+typedef struct sortEntry {
+    int rosterNum;
+    char* name;
+} sortEntry_t;
+
+int compareRosters(const void* a, const void* b) {
+    int x = ((const sortEntry_t*)a)->rosterNum;
+    int y = ((const sortEntry_t*)b)->rosterNum;
+    return (x > y) - (x < y);
+}
+
+int compareNames(const void* a, const void* b) {
+    return strcmp(((const sortEntry_t*)a)->name, ((const sortEntry_t*)b)->name);
+}
+
+// Sorts t the way it was done before team_sort: copy every player out,
+// qsort the copies and push them onto a new team.
+// Returns the sorted team, t is freed.
+team_t* copySort(team_t* t, int key) {
+    int size = team_size(t);
+    sortEntry_t* entries = (sortEntry_t*)malloc(sizeof(sortEntry_t) * size);
+    player_t* p;
+    int i = 0;
+    for (p = t->head; p != NULL; p = p->next) {
+        entries[i].rosterNum = p->rosterNum;
+        entries[i].name = p->name;
+        i++;
+    }
+    qsort(entries, size, sizeof(sortEntry_t), key == TEAM_SORT_ROSTER ? compareRosters : compareNames);
+
+    team_t* sorted = create_team();
+    for (i = 0; i < size; i++) {
+        team_push_back(sorted, entries[i].rosterNum, entries[i].name);
+    }
+    free(entries);
+    free_team(t);
+    return sorted;
+}
+
+// Runs team_sort and copySort by roster and by name for sizes 1000 up to
+// maxSize.
+void sortSuite(int maxSize, int json) {
+    char* sortNames[4] = {"team_sort_roster", "copy_qsort_roster", "team_sort_name", "copy_qsort_name"};
+    int rows = 0;
+    int size;
+    for (size = 1000; size <= maxSize; size *= 10) {
+        rows += 4;
+    }
+    opsResult_t* results = (opsResult_t*)malloc(sizeof(opsResult_t) * (rows > 0 ? rows : 1));
+
+    int row = 0;
+    for (size = 1000; size <= maxSize; size *= 10) {
+        int samples = (int)(OPS_FREE_BUDGET / size);
+        samples = samples < 3 ? 3 : (samples > 100 ? 100 : samples);
+        int method;
+        for (method = 0; method < 4; method++) {
+            int key = method < 2 ? TEAM_SORT_ROSTER : TEAM_SORT_NAME;
+            long long* nanos = (long long*)malloc(sizeof(long long) * samples);
+            unsigned int seed = 88172645u ^ (unsigned int)size;
+            int i;
+            for (i = 0; i < samples; i++) {
+                team_t* t = benchNamedTeam(size, &seed);
+                long long start = nowNanos();
+                if (method % 2 == 0) {
+                    team_sort(t, key);
+                }
+                else {
+                    t = copySort(t, key);
+                }
+                nanos[i] = nowNanos() - start;
+                free_team(t);
+            }
+
+            opsResult_t* r = &results[row++];
+            r->backend = "linked";
+            r->op = sortNames[method];
+            r->size = size;
+            r->threads = 1;
+            summarizeNanos(r, nanos, samples);
+            free(nanos);
+        }
+    }
+
+    for (row = 0; row < rows; row++) {
+        printResult(&results[row], json, row == 0, row == rows - 1);
+    }
+    free(results);
+}
+
+// Returns 1 if the roster number of p is even, arg is unused.
+int rosterIsEven(player_t* p, void* arg) {
+    (void)arg;
+    return (p->rosterNum & 1) == 0;
+}
+
+// Runs team_sort_parallel, team_summarize_parallel and
+// team_count_if_parallel on a team of size players with 1, 2, 4 and so
+// on up to every core.
+void parallelSuite(int size, int json) {
+    char* parallelNames[3] = {"team_sort_parallel", "team_summarize_parallel", "team_count_if_parallel"};
+    int cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    int rows = 0;
+    int threads;
+    for (threads = 1; threads < 2 * cores; threads *= 2) {
+        rows += 3;
+    }
+    opsResult_t* results = (opsResult_t*)malloc(sizeof(opsResult_t) * rows);
+
+    int row = 0;
+    for (threads = 1; threads < 2 * cores; threads *= 2) {
+        int t = threads < cores ? threads : cores;
+        team_workers_t* workers = create_team_workers(t);
+        int samples = 5;
+        int method;
+        for (method = 0; method < 3; method++) {
+            long long nanos[5];
+            unsigned int seed = 88172645u ^ (unsigned int)size;
+            team_t* team = benchNamedTeam(size, &seed);
+            int i;
+            for (i = 0; i < samples; i++) {
+                if (method == 0 && i > 0) {
+                    free_team(team);
+                    team = benchNamedTeam(size, &seed);
+                }
+                team_summary_t summary;
+                long long start = nowNanos();
+                if (method == 0) {
+                    team_sort_parallel(workers, team, TEAM_SORT_ROSTER);
+                }
+                else if (method == 1) {
+                    team_summarize_parallel(workers, team, &summary);
+                }
+                else {
+                    team_count_if_parallel(workers, team, rosterIsEven, NULL);
+                }
+                nanos[i] = nowNanos() - start;
+            }
+            free_team(team);
+
+            opsResult_t* r = &results[row++];
+            r->backend = "linked";
+            r->op = parallelNames[method];
+            r->size = size;
+            r->threads = t;
+            summarizeNanos(r, nanos, samples);
+        }
+        free_team_workers(workers);
+    }
+
+    for (row = 0; row < rows; row++) {
+        printResult(&results[row], json, row == 0, row == rows - 1);
+    }
+    free(results);
+}
+
+// Times rebuilding a team of size players one team_push_back at a time
+// against saving it with team_save and loading it back with team_load,
+// into a plain and a pooled team.
+void fileSuite(int size, int json) {
+    char* fileNames[4] = {"push_back_rebuild", "team_save", "team_load", "team_load_pooled"};
+    char* path = "dll_bench.team";
+    opsResult_t results[4];
+    unsigned int seed = 88172645u ^ (unsigned int)size;
+    team_t* source = benchNamedTeam(size, &seed);
+    team_config_t pooled;
+    pooled.flags = TEAM_POOLED;
+
+    int method;
+    for (method = 0; method < 4; method++) {
+        long long nanos[5];
+        int samples = 5;
+        int i;
+        for (i = 0; i < samples; i++) {
+            team_t* t = NULL;
+            long long start = nowNanos();
+            if (method == 0) {
+                t = create_team();
+                player_t* p;
+                for (p = source->head; p != NULL; p = p->next) {
+                    team_push_back(t, p->rosterNum, p->name);
+                }
+            }
+            else if (method == 1) {
+                team_save(source, path);
+            }
+            else {
+                t = team_load(path, method == 3 ? &pooled : NULL);
+            }
+            nanos[i] = nowNanos() - start;
+            free_team(t);
+        }
+
+        opsResult_t* r = &results[method];
+        r->backend = method == 3 ? "pooled" : "linked";
+        r->op = fileNames[method];
+        r->size = size;
+        r->threads = 1;
+        summarizeNanos(r, nanos, samples);
+    }
+    free_team(source);
+    remove(path);
+
+    for (method = 0; method < 4; method++) {
+        printResult(&results[method], json, method == 0, method == 3);
+    }
+}
+
+// Times getting rid of a team of size players: free_team on a plain and a
+// pooled team, team_clear on both, and team_free_deferred on a plain team,
+// which only counts the time the caller waits.
+void teardownSuite(int size, int json) {
+    char* teardownNames[5] = {"free_team", "free_team", "team_clear", "team_clear", "team_free_deferred"};
+    opsResult_t results[5];
+    team_config_t pooled;
+    pooled.flags = TEAM_POOLED;
+    team_reaper_t* reaper = create_team_reaper();
+
+    int method;
+    for (method = 0; method < 5; method++) {
+        long long nanos[5];
+        int samples = 5;
+        int i;
+        for (i = 0; i < samples; i++) {
+            unsigned int seed = 88172645u ^ (unsigned int)size;
+            team_t* t = create_team_with(method % 2 == 1 ? &pooled : NULL);
+            int k;
+            for (k = 0; k < size; k++) {
+                char name[20];
+                unsigned int r = benchRandom(&seed);
+                sprintf(name, "player-%08x", r);
+                team_push_back(t, r % 1000000, name);
+            }
+
+            long long start = nowNanos();
+            if (method < 2) {
+                free_team(t);
+            }
+            else if (method < 4) {
+                team_clear(t);
+            }
+            else {
+                team_free_deferred(reaper, t);
+            }
+            nanos[i] = nowNanos() - start;
+            if (method == 2 || method == 3) {
+                free_team(t);
+            }
+        }
+
+        opsResult_t* r = &results[method];
+        r->backend = method % 2 == 1 ? "pooled" : "linked";
+        r->op = teardownNames[method];
+        r->size = size;
+        r->threads = 1;
+        summarizeNanos(r, nanos, samples);
+    }
+    free_team_reaper(reaper);
+
+    for (method = 0; method < 5; method++) {
+        printResult(&results[method], json, method == 0, method == 4);
+    }
+}
+
+// Prints the multi-threaded benchmark tables.
+void queueSuite(int opsPerThread) {
+    int cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (cores < 2) {
+        cores = 2;
+    }
+
+    printf("queue: producers push_back, consumers pop_front, %d players per producer\n", opsPerThread);
+    printf("%8s %16s %16s %16s\n", "threads", "mutex Mops/s", "two-lock Mops/s", "lock-free Mops/s");
+    int threads;
+    for (threads = 2; threads <= cores; threads *= 2) {
+        double locked = queueBenchmark(QUEUE_MUTEX, threads, opsPerThread);
+        double twoLock = queueBenchmark(QUEUE_TWO_LOCK, threads, opsPerThread);
+        double lockFree = queueBenchmark(QUEUE_LOCK_FREE, threads, opsPerThread);
+        printf("%8d %16.2f %16.2f %16.2f\n", threads, locked, twoLock, lockFree);
+    }
+
+    printf("\nwork queue: each worker pushes and pops batches of %d, %d players per worker\n", WORK_BATCH, opsPerThread);
+    printf("%8s %16s %16s\n", "threads", "mutex Mops/s", "sharded Mops/s");
+    for (threads = 1; threads <= cores; threads *= 2) {
+        double locked = workBenchmark(0, threads, opsPerThread);
+        double sharded = workBenchmark(1, threads, opsPerThread);
+        printf("%8d %16.2f %16.2f\n", threads, locked, sharded);
+    }
+}
+
+int main(int argc, char** argv){
+    char* suite = argc > 1 ? argv[1] : "ops";
+    int json = argc > 3 && strcmp(argv[3], "json") == 0;
+
+    if (strcmp(suite, "queue") == 0) {
+        queueSuite(argc > 2 ? atoi(argv[2]) : 200000);
+    }
+    else if (strcmp(suite, "ops") == 0) {
+        opsSuite(argc > 2 ? atoi(argv[2]) : 100000, json);
+    }
+    else if (strcmp(suite, "sort") == 0) {
+        sortSuite(argc > 2 ? atoi(argv[2]) : 1000000, json);
+    }
+    else if (strcmp(suite, "parallel") == 0) {
+        parallelSuite(argc > 2 ? atoi(argv[2]) : 1000000, json);
+    }
+    else if (strcmp(suite, "file") == 0) {
+        fileSuite(argc > 2 ? atoi(argv[2]) : 1000000, json);
+    }
+    else if (strcmp(suite, "teardown") == 0) {
+        teardownSuite(argc > 2 ? atoi(argv[2]) : 1000000, json);
+    }
+    else {
+        fprintf(stderr, "usage: %s [ops|sort|parallel|file|teardown|queue] [size] [csv|json]\n", argv[0]);
+        return 1;
+    }
+
+    return 0;
+}
@@ -3,6 +3,79 @@
 #include <stdlib.h>
 #include <string.h>
 #include "my_dll.h"
+#define MYDLL_CONCURRENT_IMPLEMENTATION
+#include "my_dll_concurrent.h"
+#include "my_dll_parallel.h"
+#include "my_dll_file.h"
+
+// Helper for the randomized tests
+// Runs ops random pushes, pops, inserts, gets and removes against test
+// and against a plain array holding the same roster numbers.
+// Returns 1 if the team and the array agreed the whole way through.
+int matchesModel(team_t* test, int ops, unsigned int seed) {
+    int* model = (int*)malloc(sizeof(int) * (ops + 1));
+    int size = 0;
+    int agreed = 1;
+    char name[40];
+    int i;
+
+    srand(seed);
+    for (i = 0; i < ops && agreed; i++) {
+        int op = rand() % 8;
+        int pos = size > 0 ? rand() % (size + 1) : 0;
+        player_t* p = NULL;
+        sprintf(name, i % 3 == 0 ? "player-with-a-long-name-%d" : "p%d", i);
+
+        if (op == 0) {
+            team_push_front(test, i, name);
+            memmove(model + 1, model, sizeof(int) * size);
+            model[0] = i;
+            size++;
+        }
+        else if (op == 1) {
+            team_push_back(test, i, name);
+            model[size++] = i;
+        }
+        else if (op == 2 || op == 3) {
+            team_insert(test, pos, i, name);
+            memmove(model + pos + 1, model + pos, sizeof(int) * (size - pos));
+            model[pos] = i;
+            size++;
+        }
+        else if (op == 4 && size > 0) {
+            p = team_pop_front(test);
+            agreed = p != NULL && p->rosterNum == model[0];
+            memmove(model, model + 1, sizeof(int) * --size);
+        }
+        else if (op == 5 && size > 0) {
+            p = team_pop_back(test);
+            agreed = p != NULL && p->rosterNum == model[--size];
+        }
+        else if (op == 6 && pos < size) {
+            p = team_list_remove(test, pos);
+            agreed = p != NULL && p->rosterNum == model[pos];
+            memmove(model + pos, model + pos + 1, sizeof(int) * (size - pos - 1));
+            size--;
+        }
+        else if (pos < size) {
+            agreed = team_list_get(test, pos) == model[pos];
+        }
+        free_player(p);
+
+        agreed = agreed && team_size(test) == size;
+    }
+
+    // a final sequential sweep in both directions
+    for (i = 0; i < size && agreed; i++) {
+        agreed = team_list_get(test, i) == model[i];
+    }
+    for (i = size - 1; i >= 0 && agreed; i--) {
+        agreed = team_list_get(test, i) == model[i];
+    }
+
+    free(model);
+    return agreed;
+}
 
 // Tests creation and deletion of list
 int unitTest0(int status){
@@ -59,8 +132,7 @@ int unitTest3(int status){
 
     team_push_back(test, 6, player);
     player_t* popPlayer = team_pop_back(test);
-    free(popPlayer->name);
-    free(popPlayer);
+    free_player(popPlayer);
     if(0==team_size(test)){
        passed = 1;
     }else{
@@ -82,8 +154,7 @@ int unitTest4(int status){
     team_push_back(test, 96, player1);
     team_push_front(test, 65, player2);
     player_t* popPlayer = team_pop_back(test);
-    free(popPlayer->name);
-    free(popPlayer);
+    free_player(popPlayer);
 
     if(1==team_size(test)){
        passed = 1;
@@ -108,8 +179,7 @@ int unitTest5(int status){
     team_push_back(test, 65, player2);
 
     player_t* popPlayer = team_pop_back(test);
-    free(popPlayer->name);
-    free(popPlayer);
+    free_player(popPlayer);
 
     if(1==team_size(test)){
        passed = 1;
@@ -139,8 +209,7 @@ int unitTest6(int status){
     }else{
     	passed = 0;
     }
-    free(forward->name);
-    free(forward);
+    free_player(forward);
     free_team(test);
 
     return passed;
@@ -167,8 +236,7 @@ int unitTest7(int status){
     }else{
     	passed = 0;
     }
-    free(forward->name);
-    free(forward);
+    free_player(forward);
     free_team(test);
 
     return passed;
@@ -225,8 +293,7 @@ int unitTest9(int status){
     }else{
     	passed = 0;
     }
-    free(forward->name);
-    free(forward);
+    free_player(forward);
     free_team(test);
 
     return passed;
@@ -593,6 +660,1943 @@ int unitTest22(int status) {
     return passed;    
 }
 
+//Tests a pooled team: pushes, pops one player, frees it back
+//to the pool and checks the next push reuses its block
+int unitTest23(int status) {
+    int passed = 0;
+    team_config_t config = { TEAM_POOLED };
+    team_t* test = create_team_with(&config);
+
+    char player1[20] = "Rick";
+    char player2[20] = "Morty";
+    char player3[20] = "Justin";
+
+    team_push_back(test, 11, player1);
+    team_push_front(test, 22, player2);
+    player_t* popPlayer = team_pop_back(test);
+    int popRoster = popPlayer->rosterNum;
+    free_player(popPlayer);
+    team_insert(test, 1, 33, player3);
+
+    if (popRoster == 11 &&
+        team_size(test) == 2 &&
+        test->tail == popPlayer &&
+        strcmp(test->tail->name, "Justin") == 0 &&
+        strcmp(test->head->name, "Morty") == 0 &&
+        (test->head->flags & PLAYER_NODE_POOL)) {
+        passed = 1;
+    }
+    else {
+        passed = 0;
+    }
+    free_team(test);
+
+    return passed;
+}
+
+//Tests a pooled team spanning several slabs and a name too long
+//for a regular arena chunk, then frees the whole team at once
+int unitTest24(int status) {
+    int passed = 1;
+    team_config_t config = { TEAM_POOLED };
+    team_t* test = create_team_with(&config);
+
+    char* longName = (char*)malloc(TEAM_ARENA_BYTES);
+    memset(longName, 'x', TEAM_ARENA_BYTES - 1);
+    longName[TEAM_ARENA_BYTES - 1] = '\0';
+
+    char player[20] = "Roiland";
+    int i;
+    for (i = 0; i < 5000; i++) {
+        team_push_back(test, i, player);
+    }
+    team_push_front(test, -1, longName);
+
+    if (team_size(test) != 5001 ||
+        strcmp(test->head->name, longName) != 0 ||
+        team_list_get(test, 4000) != 3999) {
+        passed = 0;
+    }
+    free(longName);
+    free_team(test);
+
+    return passed;
+}
+
+//Tests names right at and past the inline name limit, the short
+//one stays inside the player and the long one is allocated
+int unitTest25(int status) {
+    int passed = 0;
+    team_t* test = create_team();
+
+    char shortName[PLAYER_INLINE_NAME];
+    char longName[PLAYER_INLINE_NAME + 1];
+    memset(shortName, 's', PLAYER_INLINE_NAME - 1);
+    shortName[PLAYER_INLINE_NAME - 1] = '\0';
+    memset(longName, 'l', PLAYER_INLINE_NAME);
+    longName[PLAYER_INLINE_NAME] = '\0';
+
+    team_push_back(test, 1, shortName);
+    team_push_back(test, 2, longName);
+
+    if (test->head->name == test->head->inlineName &&
+        test->tail->name != test->tail->inlineName &&
+        strcmp(test->head->name, shortName) == 0 &&
+        strcmp(test->tail->name, longName) == 0 &&
+        sizeof(player_t) <= 64) {
+        passed = 1;
+    }
+    else {
+        passed = 0;
+    }
+    free_player(team_pop_back(test));
+    free_team(test);
+
+    return passed;
+}
+
+//Tests an indexed team: finds and removes players by roster number
+//after pushes, inserts and pops
+int unitTest26(int status) {
+    int passed = 0;
+    team_config_t config = { TEAM_INDEXED };
+    team_t* test = create_team_with(&config);
+
+    char player1[20] = "Rick";
+    char player2[20] = "Morty";
+    char player3[20] = "Justin";
+    char player4[20] = "Roiland";
+
+    team_push_back(test, 11, player1);
+    team_push_front(test, 22, player2);
+    team_insert(test, 1, 33, player3);
+    team_push_back(test, 44, player4);
+    free_player(team_pop_front(test));
+
+    player_t* found = team_find_by_roster(test, 33);
+    player_t* removed = team_remove_by_roster(test, 11);
+
+    if (found != NULL &&
+        strcmp(found->name, "Justin") == 0 &&
+        team_find_by_roster(test, 22) == NULL &&
+        removed != NULL &&
+        strcmp(removed->name, "Rick") == 0 &&
+        team_find_by_roster(test, 11) == NULL &&
+        team_size(test) == 2 &&
+        test->head == found &&
+        test->tail->previous == found) {
+        passed = 1;
+    }
+    else {
+        passed = 0;
+    }
+    free_player(removed);
+    free_team(test);
+
+    return passed;
+}
+
+//Tests the index through growth and heavy removal, with shared
+//roster numbers, against a plain team scanned from the head
+int unitTest27(int status) {
+    int passed = 1;
+    team_config_t config = { TEAM_INDEXED };
+    team_t* test = create_team_with(&config);
+    team_t* plain = create_team();
+
+    char player[20] = "Morty";
+    int i;
+    for (i = 0; i < 2000; i++) {
+        team_push_back(test, i % 700, player);
+        team_push_back(plain, i % 700, player);
+    }
+    for (i = 0; i < 1500; i += 3) {
+        free_player(team_list_remove(test, i % team_size(test)));
+        free_player(team_list_remove(plain, i % team_size(plain)));
+    }
+    for (i = 0; i < 700; i += 2) {
+        free_player(team_remove_by_roster(test, i));
+        free_player(team_remove_by_roster(plain, i));
+    }
+    for (i = 0; i < 700; i++) {
+        if ((team_find_by_roster(test, i) == NULL) !=
+            (team_find_by_roster(plain, i) == NULL)) {
+            passed = 0;
+        }
+    }
+    if (team_size(test) != team_size(plain) ||
+        test->index->used != team_size(test)) {
+        passed = 0;
+    }
+    free_team(test);
+    free_team(plain);
+
+    return passed;
+}
+
+//Tests positional access walking from the head, the tail and the
+//cursor with a random mix of operations
+int unitTest28(int status) {
+    int passed = 0;
+    team_t* test = create_team();
+
+    passed = matchesModel(test, 5000, 28);
+    free_team(test);
+
+    return passed;
+}
+
+//Tests the cursor stays on the right player across pushes, pops
+//and removes at the cursor position
+int unitTest29(int status) {
+    int passed = 0;
+    team_t* test = create_team();
+
+    char player[20] = "Rick";
+    int i;
+    for (i = 0; i < 10; i++) {
+        team_push_back(test, i, player);
+    }
+    team_list_get(test, 4);
+    team_push_front(test, 100, player);
+    free_player(team_list_remove(test, 5));
+    free_player(team_pop_front(test));
+
+    if (test->cursorPos == 4 &&
+        test->cursor->rosterNum == 5 &&
+        team_list_get(test, 4) == 5 &&
+        team_list_get(test, 5) == 6 &&
+        team_list_get(test, 8) == 9) {
+        passed = 1;
+    }
+    else {
+        passed = 0;
+    }
+    free_team(test);
+
+    return passed;
+}
+
+//Tests positional access through the skip list with a random mix
+//of operations, on a plain and on a pooled and indexed team
+int unitTest30(int status) {
+    int passed = 0;
+    team_config_t config = { TEAM_SKIPLIST };
+    team_config_t allConfig = { TEAM_SKIPLIST | TEAM_POOLED | TEAM_INDEXED };
+    team_t* test = create_team_with(&config);
+    team_t* all = create_team_with(&allConfig);
+
+    passed = matchesModel(test, 20000, 30) && matchesModel(all, 20000, 31);
+    free_team(test);
+    free_team(all);
+
+    return passed;
+}
+
+//Tests a skip list team grown to 100000 players from both ends
+//then emptied from the middle, checking positions along the way
+int unitTest31(int status) {
+    int passed = 1;
+    team_config_t config = { TEAM_SKIPLIST };
+    team_t* test = create_team_with(&config);
+
+    char player[20] = "Justin";
+    int i;
+    for (i = 0; i < 50000; i++) {
+        team_push_back(test, 50000 + i, player);
+        team_push_front(test, 49999 - i, player);
+    }
+    for (i = 0; i < 100000; i += 997) {
+        if (team_list_get(test, i) != i) {
+            passed = 0;
+        }
+    }
+    while (team_size(test) > 0 && passed) {
+        int pos = team_size(test) / 2;
+        int expected = team_list_get(test, pos);
+        player_t* removed = team_list_remove(test, pos);
+        if (removed->rosterNum != expected || removed->tower != NULL) {
+            passed = 0;
+        }
+        free_player(removed);
+    }
+    if (test->skip->level != 0) {
+        passed = 0;
+    }
+    free_team(test);
+
+    return passed;
+}
+
+//Tests an unrolled team with a random mix of operations
+int unitTest32(int status) {
+    int passed = 0;
+    team_config_t config = { TEAM_UNROLLED };
+    team_t* test = create_team_with(&config);
+
+    passed = matchesModel(test, 20000, 32) &&
+             test->head == NULL &&
+             test->tail == NULL;
+    free_team(test);
+
+    return passed;
+}
+
+//Tests an unrolled team hands back players that own their names,
+//and removes by roster number
+int unitTest33(int status) {
+    int passed = 0;
+    team_config_t config = { TEAM_UNROLLED };
+    team_config_t badConfig = { TEAM_UNROLLED | TEAM_SKIPLIST };
+    team_t* test = create_team_with(&config);
+
+    char player1[20] = "Rick";
+    char player2[20] = "Morty";
+    char player3[20] = "Justin";
+    int i;
+    for (i = 0; i < 40; i++) {
+        team_push_back(test, i, player3);
+    }
+    team_insert(test, 20, 99, player1);
+    team_push_front(test, 77, player2);
+
+    player_t* front = team_pop_front(test);
+    player_t* removed = team_remove_by_roster(test, 99);
+
+    if (create_team_with(&badConfig) == NULL &&
+        strcmp(front->name, "Morty") == 0 &&
+        front->rosterNum == 77 &&
+        removed != NULL &&
+        strcmp(removed->name, "Rick") == 0 &&
+        team_remove_by_roster(test, 99) == NULL &&
+        team_find_by_roster(test, 5) == NULL &&
+        team_size(test) == 40 &&
+        team_list_get(test, 20) == 20) {
+        passed = 1;
+    }
+    else {
+        passed = 0;
+    }
+    free_player(front);
+    free_player(removed);
+    free_team(test);
+
+    return passed;
+}
+
+//Tests a compact team with a random mix of operations
+int unitTest34(int status) {
+    int passed = 0;
+    team_config_t config = { TEAM_COMPACT };
+    team_t* test = create_team_with(&config);
+
+    passed = matchesModel(test, 20000, 34) &&
+             test->head == NULL &&
+             test->tail == NULL;
+    free_team(test);
+
+    return passed;
+}
+
+//Tests a compact team reuses freed slots instead of growing, and
+//removes by roster number
+int unitTest35(int status) {
+    int passed = 1;
+    team_config_t config = { TEAM_COMPACT };
+    team_t* test = create_team_with(&config);
+
+    char player[20] = "Roiland";
+    int i;
+    for (i = 0; i < 100; i++) {
+        team_push_back(test, i, player);
+    }
+    uint32_t capacity = test->slots->capacity;
+    for (i = 0; i < 1000; i++) {
+        free_player(team_pop_front(test));
+        team_push_back(test, 100 + i, player);
+    }
+
+    player_t* removed = team_remove_by_roster(test, 1050);
+    if (test->slots->capacity != capacity ||
+        removed == NULL ||
+        removed->rosterNum != 1050 ||
+        strcmp(removed->name, "Roiland") != 0 ||
+        team_size(test) != 99 ||
+        team_list_get(test, 50) != 1051) {
+        passed = 0;
+    }
+    free_player(removed);
+    free_team(test);
+
+    return passed;
+}
+
+// Helper for the bulk tests
+// Fills rosters and names with count players numbered from first, every
+// third one with a name too long to keep inline.
+void makeRoster(int count, int first, int* rosters, char** names) {
+    int i;
+    for (i = 0; i < count; i++) {
+        rosters[i] = first + i;
+        names[i] = (char*)malloc(48);
+        sprintf(names[i], i % 3 == 0 ? "a-rather-long-player-name-number-%d" : "n%d", first + i);
+    }
+}
+
+//Tests bulk pushes at both ends spanning several slabs, then frees
+//players one by one and the rest with the team
+int unitTest36(int status) {
+    int passed = 1;
+    team_t* test = create_team();
+
+    int count = 3000;
+    int* rosters = (int*)malloc(sizeof(int) * count);
+    char** names = (char**)malloc(sizeof(char*) * count);
+    makeRoster(count, 0, rosters, names);
+
+    char player[20] = "Rick";
+    team_push_back(test, -1, player);
+    team_push_back_bulk(test, count, rosters, names);
+    team_push_front_bulk(test, 100, rosters, names);
+
+    int i;
+    if (team_size(test) != count + 101 ||
+        team_list_get(test, 0) != 0 ||
+        team_list_get(test, 99) != 99 ||
+        team_list_get(test, 100) != -1 ||
+        team_list_get(test, count + 100) != count - 1 ||
+        test->tail->next != NULL ||
+        test->head->previous != NULL) {
+        passed = 0;
+    }
+    for (i = 0; i < 2000; i++) {
+        player_t* popPlayer = team_pop_back(test);
+        if (strcmp(popPlayer->name, names[count - 1 - i]) != 0) {
+            passed = 0;
+        }
+        free_player(popPlayer);
+    }
+    for (i = 0; i < count; i++) {
+        free(names[i]);
+    }
+    free(rosters);
+    free(names);
+    free_team(test);
+
+    return passed;
+}
+
+//Tests bulk pushes on pooled, indexed and skip listed, and unrolled
+//teams, including small batches
+int unitTest37(int status) {
+    int passed = 1;
+    team_config_t configs[3] = {
+        { TEAM_POOLED },
+        { TEAM_INDEXED | TEAM_SKIPLIST },
+        { TEAM_UNROLLED }
+    };
+
+    int count = 1500;
+    int* rosters = (int*)malloc(sizeof(int) * count);
+    char** names = (char**)malloc(sizeof(char*) * count);
+    makeRoster(count, 0, rosters, names);
+
+    int c;
+    for (c = 0; c < 3; c++) {
+        team_t* test = create_team_with(&configs[c]);
+        team_push_back_bulk(test, count - 10, rosters + 10, names + 10);
+        team_push_front_bulk(test, 10, rosters, names);
+        free_player(team_pop_front(test));
+
+        int i;
+        for (i = 1; i < count; i += 37) {
+            if (team_list_get(test, i - 1) != i) {
+                passed = 0;
+            }
+        }
+        if (team_size(test) != count - 1 ||
+            team_push_back_bulk(NULL, count, rosters, names) != -1 ||
+            team_push_back_bulk(test, -1, rosters, names) != 0) {
+            passed = 0;
+        }
+        if (test->index != NULL &&
+            strcmp(team_find_by_roster(test, 999)->name, names[999]) != 0) {
+            passed = 0;
+        }
+        free_team(test);
+    }
+
+    int i;
+    for (i = 0; i < count; i++) {
+        free(names[i]);
+    }
+    free(rosters);
+    free(names);
+
+    return passed;
+}
+
+//Tests splicing one team into the middle of another, then splitting
+//it back off, checking order, sizes and both ends
+int unitTest38(int status) {
+    int passed = 1;
+    team_t* test = create_team();
+    team_t* other = create_team();
+
+    char player[20] = "Justin";
+    int i;
+    for (i = 0; i < 10; i++) {
+        team_push_back(test, i, player);
+        team_push_back(other, 100 + i, player);
+    }
+
+    team_splice(test, 4, other);
+    if (team_size(test) != 20 ||
+        team_size(other) != 0 ||
+        other->head != NULL ||
+        team_list_get(test, 3) != 3 ||
+        team_list_get(test, 4) != 100 ||
+        team_list_get(test, 13) != 109 ||
+        team_list_get(test, 14) != 4 ||
+        test->tail->rosterNum != 9) {
+        passed = 0;
+    }
+
+    team_t* rest = team_split(test, 14);
+    team_t* empty = team_split(test, 14);
+    if (team_size(test) != 14 ||
+        team_size(rest) != 6 ||
+        team_size(empty) != 0 ||
+        test->tail->rosterNum != 109 ||
+        test->tail->next != NULL ||
+        rest->head->rosterNum != 4 ||
+        rest->head->previous != NULL ||
+        team_split(test, 15) != NULL ||
+        team_splice(test, 0, test) != 0) {
+        passed = 0;
+    }
+
+    team_splice(test, 0, rest);
+    if (team_size(test) != 20 ||
+        test->head->rosterNum != 4 ||
+        team_list_get(test, 6) != 0) {
+        passed = 0;
+    }
+    free_team(test);
+    free_team(other);
+    free_team(rest);
+    free_team(empty);
+
+    return passed;
+}
+
+//Tests split and splice keep the index and skip list of the teams
+//involved right, and that split pooled teams share their pool
+int unitTest39(int status) {
+    int passed = 1;
+    team_config_t config = { TEAM_INDEXED | TEAM_SKIPLIST | TEAM_POOLED };
+    team_t* test = create_team_with(&config);
+
+    char player[20] = "Morty";
+    int i;
+    for (i = 0; i < 1000; i++) {
+        team_push_back(test, i, player);
+    }
+
+    team_t* rest = team_split(test, 300);
+    if (rest->pool != test->pool ||
+        team_find_by_roster(test, 500) != NULL ||
+        team_find_by_roster(rest, 500) == NULL ||
+        team_list_get(rest, 200) != 500 ||
+        team_list_get(test, 200) != 200) {
+        passed = 0;
+    }
+
+    free_player(team_remove_by_roster(rest, 999));
+    team_splice(test, 100, rest);
+    if (team_size(test) != 999 ||
+        team_find_by_roster(test, 998) == NULL ||
+        team_list_get(test, 100) != 300 ||
+        team_list_get(test, 798) != 998 ||
+        team_list_get(test, 799) != 100 ||
+        team_list_get(test, 998) != 299) {
+        passed = 0;
+    }
+    free_team(rest);
+    free_team(test);
+
+    return passed;
+}
+
+//Tests a concurrent team from one thread: pushes and pops at both
+//ends come out in the same order as on a plain team
+int unitTest40(int status) {
+    int passed = 0;
+    team_concurrent_t* test = create_team_concurrent();
+
+    char player1[20] = "Rick";
+    char player2[20] = "Morty";
+    char player3[40] = "Justin-with-a-name-too-long-to-inline";
+
+    team_concurrent_push_back(test, 1, player1);
+    team_concurrent_push_front(test, 2, player2);
+    team_concurrent_push_back(test, 3, player3);
+    player_t* front = team_concurrent_pop_front(test);
+    player_t* back = team_concurrent_pop_back(test);
+    int middle = team_concurrent_get(test, 0);
+    free_player(team_concurrent_pop_back(test));
+
+    if (front->rosterNum == 2 &&
+        strcmp(front->name, "Morty") == 0 &&
+        back->rosterNum == 3 &&
+        strcmp(back->name, player3) == 0 &&
+        middle == 1 &&
+        team_concurrent_size(test) == 0 &&
+        team_concurrent_pop_front(test) == NULL &&
+        team_concurrent_pop_back(test) == NULL) {
+        passed = 1;
+    }
+    else {
+        passed = 0;
+    }
+    free_player(front);
+    free_player(back);
+    free_team_concurrent(test);
+
+    return passed;
+}
+
+// Helper for the concurrent tests
+// Shared state of the producer and consumer threads.
+typedef struct threadWork {
+    team_concurrent_t* team;
+    int count;		// players each producer pushes
+    int consumed;	// players popped so far, updated atomically
+    int total;		// players all producers push together
+    long rosterSum;	// sum of popped roster numbers, updated atomically
+} threadWork_t;
+
+void* produceBack(void* arg) {
+    threadWork_t* work = (threadWork_t*)arg;
+    char player[20] = "Roiland";
+    int i;
+    for (i = 1; i <= work->count; i++) {
+        team_concurrent_push_back(work->team, i, player);
+    }
+    return NULL;
+}
+
+void* consumeFront(void* arg) {
+    threadWork_t* work = (threadWork_t*)arg;
+    while (__atomic_load_n(&work->consumed, __ATOMIC_RELAXED) < work->total) {
+        player_t* p = team_concurrent_pop_front(work->team);
+        if (p != NULL) {
+            __atomic_fetch_add(&work->rosterSum, p->rosterNum, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&work->consumed, 1, __ATOMIC_RELAXED);
+            free_player(p);
+        }
+    }
+    return NULL;
+}
+
+//Tests four producers pushing at the back of a concurrent team while
+//four consumers pop at the front, nothing is lost or popped twice
+int unitTest41(int status) {
+    int passed = 0;
+    threadWork_t work;
+    work.team = create_team_concurrent();
+    work.count = 20000;
+    work.total = 4 * work.count;
+    work.consumed = 0;
+    work.rosterSum = 0;
+
+    pthread_t threads[8];
+    int i;
+    for (i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, produceBack, &work);
+        pthread_create(&threads[4 + i], NULL, consumeFront, &work);
+    }
+    for (i = 0; i < 8; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (work.consumed == work.total &&
+        work.rosterSum == 4L * work.count * (work.count + 1) / 2 &&
+        team_concurrent_size(work.team) == 0) {
+        passed = 1;
+    }
+    else {
+        passed = 0;
+    }
+    free_team_concurrent(work.team);
+
+    return passed;
+}
+
+// Helper for the lock-free test
+// Shared state of the producer and consumer threads.
+typedef struct lockfreeWork {
+    team_lockfree_t* team;
+    int count;		// players each producer pushes
+    int consumed;	// players popped so far, updated atomically
+    int total;		// players all producers push together
+    long rosterSum;	// sum of popped roster numbers, updated atomically
+} lockfreeWork_t;
+
+void* produceLockfree(void* arg) {
+    lockfreeWork_t* work = (lockfreeWork_t*)arg;
+    char player[40] = "Roiland-with-a-name-too-long-to-inline";
+    int i;
+    for (i = 1; i <= work->count; i++) {
+        team_lockfree_push_back(work->team, i, player);
+    }
+    return NULL;
+}
+
+void* consumeLockfree(void* arg) {
+    lockfreeWork_t* work = (lockfreeWork_t*)arg;
+    while (__atomic_load_n(&work->consumed, __ATOMIC_RELAXED) < work->total) {
+        player_t* p = team_lockfree_pop_front(work->team);
+        if (p != NULL) {
+            __atomic_fetch_add(&work->rosterSum, p->rosterNum, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&work->consumed, 1, __ATOMIC_RELAXED);
+            free_player(p);
+        }
+    }
+    return NULL;
+}
+
+//Tests four producers and four consumers on a lock-free team, then
+//a single thread leaving players behind for free_team_lockfree
+int unitTest42(int status) {
+    int passed = 0;
+    lockfreeWork_t work;
+    work.team = create_team_lockfree();
+    work.count = 20000;
+    work.total = 4 * work.count;
+    work.consumed = 0;
+    work.rosterSum = 0;
+
+    pthread_t threads[8];
+    int i;
+    for (i = 0; i < 4; i++) {
+        pthread_create(&threads[i], NULL, produceLockfree, &work);
+        pthread_create(&threads[4 + i], NULL, consumeLockfree, &work);
+    }
+    for (i = 0; i < 8; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    char player[20] = "Rick";
+    team_lockfree_push_back(work.team, 7, player);
+    team_lockfree_push_back(work.team, 8, player);
+    player_t* first = team_lockfree_pop_front(work.team);
+
+    if (work.consumed == work.total &&
+        work.rosterSum == 4L * work.count * (work.count + 1) / 2 &&
+        first->rosterNum == 7 &&
+        team_lockfree_size(work.team) == 1) {
+        passed = 1;
+    }
+    else {
+        passed = 0;
+    }
+    free_player(first);
+    free_team_lockfree(work.team);
+
+    return passed;
+}
+
+//Tests the owner and thief ends of a sharded team
+int unitTest43(int status) {
+    int passed = 0;
+    team_sharded_t* t = create_team_sharded(3);
+    char player[20] = "Gunnarsson";
+    int i;
+    for (i = 1; i <= 4; i++) {
+        team_sharded_push(t, 0, i, player);
+    }
+    team_sharded_push(t, 1, 9, player);
+
+    // owners take their newest, thieves the oldest of another shard
+    player_t* mine = team_sharded_pop(t, 0);
+    player_t* own = team_sharded_pop(t, 1);
+    player_t* stolen = team_sharded_pop(t, 2);
+    player_t* stolenAgain = team_sharded_steal(t, 1);
+
+    if (mine->rosterNum == 4 &&
+        own->rosterNum == 9 &&
+        stolen->rosterNum == 1 &&
+        stolenAgain->rosterNum == 2 &&
+        team_sharded_size(t) == 1 &&
+        team_sharded_push(t, 3, 1, player) == -1 &&
+        team_sharded_pop(t, -1) == NULL &&
+        create_team_sharded(0) == NULL) {
+        passed = 1;
+    }
+    else {
+        passed = 0;
+    }
+    free_player(mine);
+    free_player(own);
+    free_player(stolen);
+    free_player(stolenAgain);
+    free_team_sharded(t);
+
+    return passed;
+}
+
+// Helper for the sharded team test
+// Shared state of the worker threads.
+typedef struct shardWork {
+    team_sharded_t* team;
+    int self;		// shard the worker owns
+    int count;		// players the worker pushes before popping
+    int* consumed;	// players popped by all workers, updated atomically
+    int total;		// players all workers push together
+    long* rosterSum;	// sum of popped roster numbers, updated atomically
+} shardWork_t;
+
+void* shardWorker(void* arg) {
+    shardWork_t* work = (shardWork_t*)arg;
+    char player[20] = "Sundin";
+    int i;
+    for (i = 1; i <= work->count; i++) {
+        team_sharded_push(work->team, work->self, i, player);
+    }
+    while (__atomic_load_n(work->consumed, __ATOMIC_RELAXED) < work->total) {
+        player_t* p = team_sharded_pop(work->team, work->self);
+        if (p != NULL) {
+            __atomic_fetch_add(work->rosterSum, p->rosterNum, __ATOMIC_RELAXED);
+            __atomic_fetch_add(work->consumed, 1, __ATOMIC_RELAXED);
+            free_player(p);
+        }
+    }
+    return NULL;
+}
+
+//Tests four workers draining a sharded team where only the first one
+//had any work, so the others live off stealing
+int unitTest44(int status) {
+    int passed = 0;
+    team_sharded_t* t = create_team_sharded(4);
+    int consumed = 0;
+    long rosterSum = 0;
+    shardWork_t work[4];
+    pthread_t threads[4];
+    int i;
+    for (i = 0; i < 4; i++) {
+        work[i].team = t;
+        work[i].self = i;
+        work[i].count = i == 0 ? 40000 : 0;
+        work[i].consumed = &consumed;
+        work[i].total = 40000;
+        work[i].rosterSum = &rosterSum;
+        pthread_create(&threads[i], NULL, shardWorker, &work[i]);
+    }
+    for (i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (consumed == 40000 &&
+        rosterSum == 40000L * 40001 / 2 &&
+        team_sharded_size(t) == 0) {
+        passed = 1;
+    }
+    else {
+        passed = 0;
+    }
+    free_team_sharded(t);
+
+    return passed;
+}
+
+//Tests that a read-copy-update scan carries on through players removed
+//under it, and that they are freed once the scan ends
+int unitTest45(int status) {
+    int passed = 0;
+    team_config_t config;
+    config.flags = TEAM_POOLED | TEAM_SKIPLIST;
+    team_rcu_t* r = create_team_rcu(&config);
+    char player[40] = "Forsberg-with-a-name-too-long-to-inline";
+    int i;
+    for (i = 0; i < 5; i++) {
+        team_rcu_push_back(r, i, player);
+    }
+
+    int reader = team_rcu_read_begin(r);
+    player_t* p = team_rcu_next(team_rcu_first(r));
+    // drop the player we are on and the one after it, add one further on
+    team_rcu_remove(r, 1);
+    team_rcu_remove(r, 1);
+    team_rcu_insert(r, 2, 7, player);
+    int seen[8];
+    int seenCount = 0;
+    for (; p != NULL; p = team_rcu_next(p)) {
+        seen[seenCount++] = p->rosterNum;
+    }
+    team_rcu_read_end(r, reader);
+    team_rcu_synchronize(r);
+
+    team_config_t unrolled;
+    unrolled.flags = TEAM_UNROLLED;
+    if (seenCount == 5 &&
+        seen[0] == 1 && seen[1] == 2 && seen[2] == 3 && seen[3] == 7 && seen[4] == 4 &&
+        team_rcu_size(r) == 4 &&
+        team_list_get(r->team, 2) == 7 &&
+        team_list_get(r->team, 3) == 4 &&
+        r->retiredCount == 0 &&
+        team_rcu_remove(r, 4) == 0 &&
+        team_rcu_insert(r, 6, 1, player) == 0 &&
+        create_team_rcu(&unrolled) == NULL) {
+        passed = 1;
+    }
+    else {
+        passed = 0;
+    }
+    free_team_rcu(r);
+
+    return passed;
+}
+
+// Helper for the read-copy-update test
+// Shared state of the writer and reader threads.
+typedef struct rcuWork {
+    team_rcu_t* team;
+    int pinned;		// players 0..pinned-1 stay on the team throughout
+    int done;		// set by the writer once it is finished, atomically
+    int badScans;	// scans that missed or reordered a pinned player, atomically
+} rcuWork_t;
+
+void* rcuWriter(void* arg) {
+    rcuWork_t* work = (rcuWork_t*)arg;
+    char player[20] = "Lidstrom";
+    unsigned int seed = 7;
+    int i;
+    for (i = 0; i < 20000; i++) {
+        int pos = rand_r(&seed) % (team_rcu_size(work->team) + 1);
+        team_rcu_insert(work->team, pos, 1000 + i, player);
+        team_rcu_remove(work->team, pos);
+    }
+    __atomic_store_n(&work->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+void* rcuReader(void* arg) {
+    rcuWork_t* work = (rcuWork_t*)arg;
+    while (!__atomic_load_n(&work->done, __ATOMIC_ACQUIRE)) {
+        int reader = team_rcu_read_begin(work->team);
+        int expected = 0;
+        player_t* p;
+        for (p = team_rcu_first(work->team); p != NULL; p = team_rcu_next(p)) {
+            if (p->rosterNum < 1000) {
+                if (p->rosterNum != expected) {
+                    break;
+                }
+                expected++;
+            }
+        }
+        team_rcu_read_end(work->team, reader);
+        if (expected != work->pinned) {
+            __atomic_fetch_add(&work->badScans, 1, __ATOMIC_RELAXED);
+        }
+    }
+    return NULL;
+}
+
+//Tests three readers scanning a read-copy-update team while a writer
+//keeps inserting and removing players around the ones that stay
+int unitTest46(int status) {
+    int passed = 0;
+    rcuWork_t work;
+    work.team = create_team_rcu(NULL);
+    work.pinned = 100;
+    work.done = 0;
+    work.badScans = 0;
+    char player[20] = "Zetterberg";
+    int i;
+    for (i = 0; i < work.pinned; i++) {
+        team_rcu_push_back(work.team, i, player);
+    }
+
+    pthread_t threads[4];
+    pthread_create(&threads[0], NULL, rcuWriter, &work);
+    for (i = 1; i < 4; i++) {
+        pthread_create(&threads[i], NULL, rcuReader, &work);
+    }
+    for (i = 0; i < 4; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (work.badScans == 0 &&
+        team_rcu_size(work.team) == work.pinned) {
+        passed = 1;
+    }
+    else {
+        passed = 0;
+    }
+    free_team_rcu(work.team);
+
+    return passed;
+}
+
+//Tests the operation counters, which are only kept when built with
+//TEAM_STATS and read as zero otherwise
+int unitTest47(int status) {
+    int passed = 0;
+    team_t* t = create_team();
+    char player[20] = "Salming";
+    int i;
+    for (i = 0; i < 100; i++) {
+        team_push_back(t, i, player);
+    }
+    team_list_get(t, 50);
+    team_find_by_roster(t, 99);
+
+    team_stats_t stats;
+    int kept = team_stats(t, &stats);
+    if (kept == 1) {
+        team_op_stats_t* get = &stats.ops[TEAM_OP_LIST_GET];
+        if (stats.ops[TEAM_OP_PUSH_BACK].calls == 100 &&
+            stats.ops[TEAM_OP_PUSH_BACK].hops == 0 &&
+            stats.ops[TEAM_OP_PUSH_BACK].hopHistogram[0] == 100 &&
+            get->calls == 1 && get->hops == 49 && get->hopHistogram[6] == 1 &&
+            stats.ops[TEAM_OP_FIND_BY_ROSTER].hops == 99 &&
+            stats.ops[TEAM_OP_POP_FRONT].calls == 0 &&
+            stats.players == 100 &&
+            stats.allocations == 100 &&
+            team_stats_reset(t) == 1 &&
+            team_stats(t, &stats) == 1 &&
+            stats.ops[TEAM_OP_PUSH_BACK].calls == 0) {
+            passed = 1;
+        }
+    }
+    else if (kept == 0 &&
+             stats.ops[TEAM_OP_PUSH_BACK].calls == 0 &&
+             stats.players == 0 &&
+             team_stats_reset(t) == 0) {
+        passed = 1;
+    }
+    if (team_stats(NULL, &stats) != -1 || team_stats(t, NULL) != -1) {
+        passed = 0;
+    }
+    free_team(t);
+
+    return passed;
+}
+
+// Helper for the sort tests
+// Fills t with count players in a fixed random order, then sorts it by
+// key, with team_sort_parallel on workers if that is not NULL, and pops
+// every player off the front, checking they came out sorted
+// and that players comparing equal kept the order they were pushed in.
+// Sorting by roster the name carries the push order, sorting by name the
+// roster does.
+// Returns 1 if the team sorted correctly, 0 otherwise.
+int sortsStably(team_t* t, int count, int key, team_workers_t* workers) {
+    unsigned int seed = 99;
+    char name[20];
+    int i;
+    for (i = 0; i < count; i++) {
+        int group = rand_r(&seed) % 50;
+        if (key == TEAM_SORT_ROSTER) {
+            sprintf(name, "order-%06d", i);
+            team_push_back(t, group, name);
+        }
+        else {
+            sprintf(name, "group-%02d", group);
+            team_push_back(t, i, name);
+        }
+    }
+
+    int sorted = workers != NULL ? team_sort_parallel(workers, t, key) : team_sort(t, key);
+    if (sorted != 1 || team_size(t) != count) {
+        return 0;
+    }
+
+    player_t* last = NULL;
+    for (i = 0; i < count; i++) {
+        player_t* p = team_pop_front(t);
+        if (p == NULL) {
+            return 0;
+        }
+        if (last != NULL) {
+            int order = key == TEAM_SORT_ROSTER ? p->rosterNum - last->rosterNum : strcmp(p->name, last->name);
+            int pushed = key == TEAM_SORT_ROSTER ? strcmp(p->name, last->name) : p->rosterNum - last->rosterNum;
+            if (order < 0 || (order == 0 && pushed <= 0)) {
+                sorted = 0;
+            }
+        }
+        free_player(last);
+        last = p;
+    }
+    free_player(last);
+
+    return sorted && team_size(t) == 0;
+}
+
+//Tests sorting linked teams, plain and skip listed, by roster and name
+int unitTest48(int status) {
+    int passed = 0;
+    team_t* plain = create_team();
+    team_t* byName = create_team();
+    team_config_t config;
+    config.flags = TEAM_SKIPLIST | TEAM_INDEXED | TEAM_POOLED;
+    team_t* express = create_team_with(&config);
+    char player[20] = "Hasek";
+    int i;
+    for (i = 0; i < 1000; i++) {
+        team_push_front(express, i, player);
+    }
+    team_list_get(express, 500);
+    team_sort(express, TEAM_SORT_ROSTER);
+
+    // walk the sorted chain backwards too
+    int backwards = 0;
+    player_t* p;
+    for (p = express->tail; p != NULL; p = p->previous) {
+        backwards++;
+    }
+
+    if (sortsStably(plain, 5000, TEAM_SORT_ROSTER, NULL) &&
+        sortsStably(byName, 5000, TEAM_SORT_NAME, NULL) &&
+        backwards == 1000 &&
+        team_list_get(express, 0) == 0 &&
+        team_list_get(express, 777) == 777 &&
+        team_list_get(express, 998) == 998 &&
+        team_find_by_roster(express, 321)->previous->rosterNum == 320 &&
+        team_sort(express, 7) == 0 &&
+        team_sort(NULL, TEAM_SORT_ROSTER) == -1) {
+        passed = 1;
+    }
+    else {
+        passed = 0;
+    }
+    free_team(plain);
+    free_team(byName);
+    free_team(express);
+
+    return passed;
+}
+
+//Tests sorting unrolled and compact teams, and teams of zero or one player
+int unitTest49(int status) {
+    int passed = 0;
+    team_config_t unrolled;
+    unrolled.flags = TEAM_UNROLLED;
+    team_config_t compact;
+    compact.flags = TEAM_COMPACT;
+    team_t* teams[4];
+    teams[0] = create_team_with(&unrolled);
+    teams[1] = create_team_with(&unrolled);
+    teams[2] = create_team_with(&compact);
+    teams[3] = create_team_with(&compact);
+    team_t* empty = create_team();
+    team_t* single = create_team_with(&compact);
+    char player[20] = "Lundqvist";
+    team_push_back(single, 1, player);
+
+    if (sortsStably(teams[0], 3000, TEAM_SORT_ROSTER, NULL) &&
+        sortsStably(teams[1], 3000, TEAM_SORT_NAME, NULL) &&
+        sortsStably(teams[2], 3000, TEAM_SORT_ROSTER, NULL) &&
+        sortsStably(teams[3], 3000, TEAM_SORT_NAME, NULL) &&
+        team_sort(empty, TEAM_SORT_NAME) == 1 &&
+        team_size(empty) == 0 &&
+        team_sort(single, TEAM_SORT_NAME) == 1 &&
+        team_list_get(single, 0) == 1) {
+        passed = 1;
+    }
+    else {
+        passed = 0;
+    }
+    int i;
+    for (i = 0; i < 4; i++) {
+        free_team(teams[i]);
+    }
+    free_team(empty);
+    free_team(single);
+
+    return passed;
+}
+
+// Helper for the parallel reduction test
+int isEven(player_t* p, void* arg) {
+    return p->rosterNum % *(int*)arg == 0;
+}
+
+//Tests the parallel summary, predicate count and sort against what a
+//single thread gets, on a plain and a skip listed team
+int unitTest50(int status) {
+    int passed = 1;
+    team_workers_t* workers = create_team_workers(4);
+    team_config_t config;
+    config.flags = TEAM_SKIPLIST;
+    team_t* teams[2];
+    teams[0] = create_team();
+    teams[1] = create_team_with(&config);
+    char player[20] = "Kurri";
+    int divisor = 2;
+    int k;
+    for (k = 0; k < 2; k++) {
+        unsigned int seed = 5;
+        long long sum = 0;
+        int i;
+        for (i = 0; i < 100000; i++) {
+            int roster = rand_r(&seed) % 20001 - 10000;
+            team_push_back(teams[k], roster, player);
+            sum += roster;
+        }
+        team_push_back(teams[k], -20000, player);
+        team_push_front(teams[k], 30000, player);
+
+        team_summary_t summary;
+        team_summary_t alone;
+        if (team_summarize_parallel(workers, teams[k], &summary) != 1 ||
+            team_summarize_parallel(NULL, teams[k], &alone) != 1 ||
+            summary.count != 100002 || summary.min != -20000 || summary.max != 30000 ||
+            summary.sum != sum + 10000 ||
+            alone.count != summary.count || alone.sum != summary.sum ||
+            team_count_if_parallel(workers, teams[k], isEven, &divisor) !=
+                team_count_if_parallel(NULL, teams[k], isEven, &divisor)) {
+            passed = 0;
+        }
+
+        team_sort_parallel(workers, teams[k], TEAM_SORT_ROSTER);
+        int backwards = 0;
+        player_t* p;
+        for (p = teams[k]->tail; p != NULL; p = p->previous) {
+            backwards++;
+        }
+        if (team_list_get(teams[k], 0) != -20000 ||
+            team_list_get(teams[k], 100001) != 30000 ||
+            team_list_get(teams[k], 50000) > team_list_get(teams[k], 50001) ||
+            backwards != 100002) {
+            passed = 0;
+        }
+    }
+
+    team_t* byName = create_team();
+    team_summary_t none;
+    if (!sortsStably(byName, 60000, TEAM_SORT_NAME, workers) ||
+        team_summarize_parallel(workers, byName, &none) != 1 ||
+        none.count != 0 || none.min != 0 ||
+        team_workers_size(workers) != 4 ||
+        team_sort_parallel(workers, NULL, TEAM_SORT_NAME) != -1) {
+        passed = 0;
+    }
+    free_team(byName);
+    free_team(teams[0]);
+    free_team(teams[1]);
+    free_team_workers(workers);
+
+    return passed;
+}
+
+// Counts the players visited into arg[0], stopping once it reaches arg[1].
+int visitUpTo(player_t* p, void* arg) {
+    int* visited = (int*)arg;
+    visited[0]++;
+    return visited[0] < visited[1];
+}
+
+//Tests sorted teams: ordered inserts, lower bounds and ranges agree with
+//a scan, also after removals.
+int unitTest51(int status) {
+    int passed = 1;
+    team_config_t config;
+    config.flags = TEAM_SORTED | TEAM_POOLED;
+    team_t* t = create_team_with(&config);
+    unsigned int seed = 17;
+    char name[20];
+    int i;
+    for (i = 0; i < 20000; i++) {
+        sprintf(name, "order-%06d", i);
+        if (team_insert_sorted(t, rand_r(&seed) % 5000, name) != 1) {
+            passed = 0;
+        }
+    }
+    player_t* p;
+    for (i = 0; i < 5000; i += 3) {
+        while ((p = team_remove_by_roster(t, i)) != NULL) {
+            free_player(p);
+        }
+    }
+
+    player_t* last = NULL;
+    int pos = 0;
+    int below = 0;
+    int inRange = 0;
+    for (p = t->head; p != NULL; p = p->next) {
+        if (last != NULL && (p->rosterNum < last->rosterNum ||
+            (p->rosterNum == last->rosterNum && strcmp(p->name, last->name) <= 0))) {
+            passed = 0;
+        }
+        if (p->rosterNum < 2500) {
+            below++;
+        }
+        if (1000 <= p->rosterNum && p->rosterNum <= 1100) {
+            inRange++;
+        }
+        if (team_lower_bound(t, p->rosterNum) > pos || team_list_get(t, pos) != p->rosterNum) {
+            passed = 0;
+        }
+        last = p;
+        pos++;
+    }
+
+    int few[2] = {0, 10};
+    int all[2] = {0, pos + 1};
+    if (pos != team_size(t) || team_lower_bound(t, 2500) != below ||
+        team_lower_bound(t, -1) != 0 || team_lower_bound(t, 5000) != pos ||
+        team_find_by_roster(t, 3) != NULL || team_find_by_roster(t, 4)->rosterNum != 4 ||
+        team_range(t, 1000, 1100, visitUpTo, few) != 10 || few[0] != 10 ||
+        team_range(t, 1000, 1100, visitUpTo, all) != inRange || all[0] != inRange ||
+        team_range(t, 1100, 1000, visitUpTo, all) != 0 || team_range(t, 0, 1, NULL, NULL) != -1) {
+        passed = 0;
+    }
+    free_team(t);
+
+    return passed;
+}
+
+//Tests that a sorted team refuses anything that would break its order.
+int unitTest52(int status) {
+    int passed = 1;
+    team_config_t config;
+    config.flags = TEAM_SORTED;
+    team_t* t = create_team_with(&config);
+    team_t* other = create_team_with(&config);
+    team_t* plain = create_team();
+    char player[20] = "Coffey";
+    int rosters[3] = {30, 40, 50};
+    int unordered[3] = {60, 55, 70};
+    char* names[3] = {player, player, player};
+
+    if (team_push_back(t, 10, player) != 1 || team_push_back(t, 5, player) != 0 ||
+        team_push_front(t, 20, player) != 0 || team_push_front(t, 1, player) != 1 ||
+        team_insert(t, 1, 7, player) != 1 || team_insert(t, 0, 8, player) != 0 ||
+        team_push_back_bulk(t, 3, rosters, names) != 1 ||
+        team_push_back_bulk(t, 3, unordered, names) != 0 ||
+        team_push_front_bulk(t, 3, rosters, names) != 0 ||
+        team_sort(t, TEAM_SORT_NAME) != 0 || team_sort(t, TEAM_SORT_ROSTER) != 1 ||
+        team_insert_sorted(plain, 1, player) != 0 || team_lower_bound(plain, 1) != -1 ||
+        team_insert_sorted(NULL, 1, player) != -1) {
+        passed = 0;
+    }
+
+    team_push_back(plain, 45, player);
+    team_insert_sorted(other, 45, player);
+    if (team_splice(t, 5, plain) != 0 || team_splice(t, 0, other) != 0 ||
+        team_splice(t, 5, other) != 1 || team_size(other) != 0) {
+        passed = 0;
+    }
+
+    team_t* rest = team_split(t, 3);
+    if (rest == NULL || team_size(t) != 3 || team_size(rest) != 4 ||
+        team_insert_sorted(rest, 35, player) != 1 || team_list_get(rest, 1) != 35 ||
+        team_push_front(rest, 31, player) != 0 || team_lower_bound(rest, 45) != 3) {
+        passed = 0;
+    }
+
+    config.flags = TEAM_SORTED | TEAM_UNROLLED;
+    if (create_team_with(&config) != NULL || create_team_rcu(&config) != NULL) {
+        passed = 0;
+    }
+    config.flags = TEAM_SORTED;
+    if (create_team_rcu(&config) != NULL) {
+        passed = 0;
+    }
+    free_team(rest);
+    free_team(plain);
+    free_team(other);
+    free_team(t);
+
+    return passed;
+}
+
+//Tests that team_save and team_load round trip every backend, that the
+//names of a loaded team outlive it on players popped off it, and that
+//broken files are refused.
+int unitTest53(int status) {
+    int passed = 1;
+    char* path = "dll_test.team";
+    char name[40];
+    int flags[5] = {0, TEAM_POOLED | TEAM_INDEXED, TEAM_SORTED, TEAM_UNROLLED, TEAM_COMPACT};
+    team_config_t config;
+    int k;
+    for (k = 0; k < 5; k++) {
+        config.flags = flags[k];
+        team_t* t = create_team_with(&config);
+        int i;
+        for (i = 0; i < 1000; i++) {
+            sprintf(name, i % 7 == 0 ? "a rather long name for %d" : "p%d", i);
+            team_push_back(t, i, name);
+        }
+        team_t* loaded = NULL;
+        if (team_save(t, path) != 1 || (loaded = team_load(path, &config)) == NULL ||
+            team_size(loaded) != 1000) {
+            passed = 0;
+        }
+        for (i = 0; loaded != NULL && i < 1000; i++) {
+            player_t* expected = team_pop_front(t);
+            player_t* got = team_pop_front(loaded);
+            if (got == NULL || got->rosterNum != expected->rosterNum ||
+                strcmp(got->name, expected->name) != 0) {
+                passed = 0;
+            }
+            free_player(expected);
+            if (i == 500 && !(flags[k] & TEAM_POOLED)) {
+                // the rest of the players go with the team, pooled players
+                // would go with the pool
+                free_team(loaded);
+                loaded = NULL;
+                sprintf(name, "p%d", i);
+                if (got == NULL || strcmp(got->name, name) != 0) {
+                    passed = 0;
+                }
+            }
+            free_player(got);
+        }
+        free_team(loaded);
+        free_team(t);
+    }
+
+    team_t* unordered = create_team();
+    team_push_back(unordered, 2, "Messier");
+    team_push_back(unordered, 1, "Lowe");
+    team_save(unordered, path);
+    config.flags = TEAM_SORTED;
+    team_t* loaded = team_load(path, NULL);
+    if (team_load(path, &config) != NULL || loaded == NULL ||
+        team_list_get(loaded, 1) != 1 || strcmp(loaded->tail->name, "Lowe") != 0) {
+        passed = 0;
+    }
+    free_team(loaded);
+
+    // cut the last name short
+    FILE* f = fopen(path, "r+b");
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    int cut = ftruncate(fileno(f), size - 1);
+    fclose(f);
+    if (cut != 0 || team_load(path, NULL) != NULL ||
+        team_save(NULL, path) != -1 || team_load("no/such/file", NULL) != NULL) {
+        passed = 0;
+    }
+
+    team_t* empty = create_team();
+    team_save(empty, path);
+    loaded = team_load(path, NULL);
+    if (loaded == NULL || team_size(loaded) != 0) {
+        passed = 0;
+    }
+    free_team(loaded);
+    free_team(empty);
+    free_team(unordered);
+    remove(path);
+
+    return passed;
+}
+
+//Tests that team_export and team_import carry a team through a file
+//across several buffers and batches, and a small one through a pipe, and
+//that a stream cut short keeps the batches read before.
+int unitTest54(int status) {
+    int passed = 1;
+    char* path = "dll_test.stream";
+    char name[300];
+    team_config_t config;
+    config.flags = TEAM_COMPACT;
+    team_t* t = create_team_with(&config);
+    int i;
+    for (i = 0; i < 5000; i++) {
+        memset(name, 'a' + i % 26, i % 280);
+        name[i % 280] = '\0';
+        team_push_back(t, i * 3, name);
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    team_t* copy = create_team();
+    team_push_back(copy, -1, "Anderson");
+    if (team_export(t, fd) != 1 || lseek(fd, 0, SEEK_SET) != 0 ||
+        team_import(copy, fd) != 1 || team_size(copy) != 5001) {
+        passed = 0;
+    }
+    player_t* p = copy->head->next;
+    for (i = 0; i < 5000 && p != NULL; i++) {
+        if (p->rosterNum != i * 3 || (int)strlen(p->name) != i % 280 ||
+            (i % 280 > 0 && p->name[0] != 'a' + i % 26)) {
+            passed = 0;
+        }
+        p = p->next;
+    }
+
+    // cut the last record short
+    off_t size = lseek(fd, 0, SEEK_END);
+    team_t* cut = create_team();
+    if (ftruncate(fd, size - 1) != 0 || lseek(fd, 0, SEEK_SET) != 0 ||
+        team_import(cut, fd) != 0 || team_size(cut) < TEAM_STREAM_BATCH ||
+        team_size(cut) >= 5000 || team_import(NULL, fd) != -1 || team_export(t, -1) != -1) {
+        passed = 0;
+    }
+    close(fd);
+    remove(path);
+
+    int ends[2];
+    config.flags = TEAM_SORTED;
+    team_t* sorted = create_team_with(&config);
+    team_t* small = create_team();
+    team_push_back(small, 7, "Fuhr");
+    team_push_back(small, 31, "Moog");
+    if (pipe(ends) != 0 || team_export(small, ends[1]) != 1 || close(ends[1]) != 0 ||
+        team_import(sorted, ends[0]) != 1 || team_size(sorted) != 2 ||
+        strcmp(sorted->tail->name, "Moog") != 0) {
+        passed = 0;
+    }
+    close(ends[0]);
+
+    free_team(small);
+    free_team(sorted);
+    free_team(cut);
+    free_team(copy);
+    free_team(t);
+
+    return passed;
+}
+
+//Tests teams sharing an intern table: equal names share one pointer
+//across plain, pooled, split and bulk pushed teams, and names go away
+//with the last player using them.
+int unitTest55(int status) {
+    int passed = 1;
+    team_names_t* names = create_team_names();
+    team_config_t config;
+    config.flags = TEAM_POOLED | TEAM_SKIPLIST;
+    team_t* plain = create_team();
+    team_t* pooled = create_team_with(&config);
+    config.flags = TEAM_UNROLLED;
+    team_t* unrolled = create_team_with(&config);
+    char name[40];
+    char* bulkNames[100];
+    int rosters[100];
+    int i;
+
+    if (team_use_names(plain, names) != 1 || team_use_names(pooled, names) != 1 ||
+        team_use_names(plain, names) != 0 || team_use_names(unrolled, names) != 0 ||
+        team_use_names(NULL, names) != -1) {
+        passed = 0;
+    }
+    for (i = 0; i < 100; i++) {
+        sprintf(name, i % 2 ? "Wayne Gretzky the %d" : "Kurri %d", i % 10);
+        team_push_back(plain, i, name);
+        team_push_front(pooled, i, name);
+        bulkNames[i] = i % 2 ? "Wayne Gretzky the 1" : "Kurri 0";
+        rosters[i] = i;
+    }
+    team_push_back_bulk(pooled, 100, rosters, bulkNames);
+
+    char* kurri = team_names_find(names, "Kurri 0");
+    if (team_names_size(names) != 10 || kurri == NULL ||
+        plain->head->name != kurri || pooled->tail->previous->name != kurri ||
+        pooled->head->name != team_names_find(names, "Wayne Gretzky the 9") ||
+        team_names_find(names, "Messier") != NULL) {
+        passed = 0;
+    }
+
+    team_t* rest = team_split(plain, 50);
+    free_team_names(names);
+    for (i = 0; i < 50; i++) {
+        free_player(team_pop_back(rest));
+    }
+    team_t* other = create_team();
+    team_push_back(other, 1, "Kurri 0");
+    if (team_names_size(names) != 10 || team_size(rest) != 0 ||
+        team_splice(plain, 0, other) != 0 || other->head->name == kurri) {
+        passed = 0;
+    }
+    free_team(plain);
+    if (team_names_size(names) != 10) {
+        passed = 0;
+    }
+
+    free_team(other);
+    free_team(rest);
+    free_team(unrolled);
+    free_team(pooled);
+
+    return passed;
+}
+
+//Tests that recycled players are reused by the next pushes, names and
+//all, without allocating, and that the spare list keeps to its limit.
+int unitTest56(int status) {
+    int passed = 1;
+    team_t* t = create_team();
+    char name[40];
+    int i;
+    for (i = 0; i < 100; i++) {
+        sprintf(name, i % 2 ? "Jari Kurri of the Oilers %03d" : "Kurri %d", i);
+        team_push_back(t, i, name);
+    }
+
+    team_stats_t before;
+    team_stats_t after;
+    team_stats(t, &before);
+    for (i = 100; i < 10000; i++) {
+        player_t* p = team_pop_front(t);
+        char* buffer = p->name;
+        team_recycle_player(t, p);
+        sprintf(name, i % 2 ? "Jari Kurri of the Oilers %03d" : "Kurri %d", i % 1000);
+        team_push_back(t, i, name);
+        if (t->tail != p || t->tail->name != buffer || strcmp(t->tail->name, name) != 0) {
+            passed = 0;
+        }
+    }
+    if (team_stats(t, &after) == 1 && after.allocations != before.allocations) {
+        passed = 0;
+    }
+
+    for (i = 0; i < 5; i++) {
+        team_recycle_player(t, team_pop_back(t));
+    }
+    if (t->spareCount != 5 || team_recycle_limit(t, 2) != 1 || t->spareCount != 2 ||
+        team_recycle_limit(t, -1) != 0 || team_recycle_player(t, NULL) != -1) {
+        passed = 0;
+    }
+    team_recycle_player(t, team_pop_back(t));
+    if (t->spareCount != 2 || team_size(t) != 94) {
+        passed = 0;
+    }
+
+    // a player of another team's pool is just freed
+    team_config_t config;
+    config.flags = TEAM_POOLED;
+    team_t* pooled = create_team_with(&config);
+    team_names_t* names = create_team_names();
+    team_t* interned = create_team();
+    team_use_names(interned, names);
+    team_push_back(pooled, 1, "Fuhr");
+    team_push_back(interned, 2, "Anderson");
+    team_recycle_limit(t, 10);
+    team_recycle_player(t, team_pop_back(pooled));
+    team_recycle_player(interned, team_pop_back(interned));
+    team_push_back(interned, 3, "Tikkanen");
+    if (t->spareCount != 2 || interned->spareCount != 0 || team_names_size(names) != 1 ||
+        interned->head->name != team_names_find(names, "Tikkanen")) {
+        passed = 0;
+    }
+
+    // the half split off keeps the limit
+    team_t* half = team_split(t, 50);
+    if (half == NULL || half->spareLimit != 10) {
+        passed = 0;
+    }
+
+    free_team_names(names);
+    free_team(interned);
+    free_team(pooled);
+    free_team(half);
+    free_team(t);
+
+    return passed;
+}
+
+//Tests that team_clear empties every kind of team, gives a pooled team's
+//memory back at once, and leaves the team ready to fill again.
+int unitTest57(int status) {
+    int passed = 1;
+    int flags[7] = {0, TEAM_POOLED, TEAM_POOLED | TEAM_INDEXED, TEAM_SORTED | TEAM_POOLED,
+                    TEAM_UNROLLED, TEAM_COMPACT, TEAM_INDEXED};
+    char name[40];
+    int k;
+    for (k = 0; k < 7; k++) {
+        team_config_t config;
+        config.flags = flags[k];
+        team_t* t = create_team_with(&config);
+        int round;
+        for (round = 0; round < 3; round++) {
+            int i;
+            for (i = 0; i < 5000; i++) {
+                sprintf(name, i % 2 ? "Grant Fuhr in goal no. %04d" : "Fuhr %d", i);
+                team_push_back(t, i + round, name);
+            }
+            team_recycle_player(t, team_pop_back(t));
+            if (t->pool != NULL) {
+                // 5000 players fit in slab allocations of 1, 2 and 4 slabs
+                int allocations = 0;
+                team_slab_t* slab;
+                for (slab = t->pool->slabs; slab != NULL; slab = slab->nextSlab) {
+                    allocations++;
+                }
+                if (allocations > 3) {
+                    passed = 0;
+                }
+            }
+            if (team_clear(t) != 1 || team_size(t) != 0 || t->head != NULL ||
+                t->spareCount != 0 || team_find_by_roster(t, 10 + round) != NULL ||
+                (t->pool != NULL && t->pool->slabs != NULL)) {
+                passed = 0;
+            }
+        }
+        team_push_back(t, 7, "Messier");
+        team_push_back(t, 11, "Gretzky's linemate");
+        if (team_size(t) != 2 || team_list_get(t, 0) != 7 ||
+            team_list_get(t, 1) != 11 || team_clear(t) != 1) {
+            passed = 0;
+        }
+        free_team(t);
+    }
+    if (team_clear(NULL) != -1) {
+        passed = 0;
+    }
+
+    return passed;
+}
+
+//Tests team_clear on a pooled team sharing its pool and intern table,
+//and teams freed by a reaper thread, also halves of one bulk block.
+int unitTest58(int status) {
+    int passed = 1;
+
+    // a pool shared with the other half of a split only takes the players back
+    team_config_t config;
+    config.flags = TEAM_POOLED;
+    team_t* t = create_team_with(&config);
+    team_names_t* names = create_team_names();
+    team_use_names(t, names);
+    char name[40];
+    int i;
+    for (i = 0; i < 1000; i++) {
+        sprintf(name, "Coffey %d", i % 10);
+        team_push_back(t, i, name);
+    }
+    team_t* back = team_split(t, 500);
+    if (team_clear(t) != 1 || team_size(back) != 500 || team_names_size(names) != 10 ||
+        team_list_get(back, 499) != 999) {
+        passed = 0;
+    }
+    team_push_back(t, 4, "Lowe");
+    free_team(back);
+    if (team_names_size(names) != 1 || team_clear(t) != 1 || team_names_size(names) != 0) {
+        passed = 0;
+    }
+    free_team(t);
+    free_team_names(names);
+
+    // teams handed to the reaper are freed by the time it is
+    team_reaper_t* reaper = create_team_reaper();
+    if (reaper == NULL) {
+        return 0;
+    }
+    int k;
+    for (k = 0; k < 8; k++) {
+        team_t* doomed = create_team();
+        for (i = 0; i < 20000; i++) {
+            sprintf(name, "Semenko the enforcer %d", i);
+            team_push_back(doomed, i, name);
+        }
+        team_free_deferred(reaper, doomed);
+    }
+    team_free_deferred(reaper, NULL);
+    team_t* last = create_team();
+    team_push_back(last, 1, "Huddy");
+    team_free_deferred(NULL, last);
+
+    // halves of one bulk block freed on the reaper and here at once
+    int rosters[4096];
+    char* bulkNames[4096];
+    for (i = 0; i < 4096; i++) {
+        rosters[i] = i;
+        bulkNames[i] = "Pocklington";
+    }
+    for (k = 0; k < 8; k++) {
+        team_t* whole = create_team();
+        team_push_back_bulk(whole, 4096, rosters, bulkNames);
+        team_t* half = team_split(whole, 2048);
+        team_free_deferred(reaper, half);
+        free_team(whole);
+    }
+    free_team_reaper(reaper);
+
+    return passed;
+}
+
+//Tests cursors: a single pass removing and inserting players on linked
+//teams of every kind, moving at both ends, and what they refuse.
+int unitTest59(int status) {
+    int passed = 1;
+    int flags[4] = {0, TEAM_POOLED | TEAM_INDEXED, TEAM_SKIPLIST, TEAM_SORTED};
+    char name[40];
+    int k;
+    for (k = 0; k < 4; k++) {
+        team_config_t config;
+        config.flags = flags[k];
+        team_t* t = create_team_with(&config);
+        int i;
+        for (i = 0; i < 3000; i++) {
+            sprintf(name, "Glenn Anderson no. %d", i);
+            team_push_back(t, i, name);
+        }
+
+        // one pass: drop the odd players, put a copy before every tenth
+        team_cursor_t c = {NULL, NULL, 0};
+        if (team_cursor_at(t, 0, &c) != 1) {
+            passed = 0;
+            free_team(t);
+            continue;
+        }
+        while (team_cursor_player(&c) != NULL) {
+            int roster = team_cursor_player(&c)->rosterNum;
+            if (roster % 2 == 1) {
+                free_player(team_cursor_remove(&c));
+                continue;
+            }
+            if (roster % 10 == 0 && team_cursor_insert(&c, roster, "copy") != 1) {
+                passed = 0;
+            }
+            if (team_list_get(t, c.pos) != roster) {
+                passed = 0;
+            }
+            team_cursor_next(&c);
+        }
+
+        // 1500 even players and 300 copies
+        if (team_size(t) != 1800 || c.pos != 1800 || team_cursor_next(&c) != 0 ||
+            team_cursor_remove(&c) != NULL || team_find_by_roster(t, 1001) != NULL ||
+            team_find_by_roster(t, 1000) == NULL) {
+            passed = 0;
+        }
+        int pos = 0;
+        int copies = 0;
+        player_t* p;
+        for (p = t->head; p != NULL; p = p->next) {
+            if (team_list_get(t, pos) != p->rosterNum || p->rosterNum % 2 != 0) {
+                passed = 0;
+            }
+            if (strcmp(p->name, "copy") == 0) {
+                copies++;
+                if (p->next->rosterNum != p->rosterNum || strcmp(p->next->name, "copy") == 0) {
+                    passed = 0;
+                }
+            }
+            pos++;
+        }
+        if (copies != 300) {
+            passed = 0;
+        }
+
+        // back from the end, and inserts past the last player go at the back
+        if (team_cursor_previous(&c) != 1 || team_cursor_player(&c) != t->tail ||
+            team_cursor_next(&c) != 1 || team_cursor_insert(&c, 5000, "Lowe") != 1 ||
+            t->tail->rosterNum != 5000 || c.pos != team_size(t) || c.player != NULL) {
+            passed = 0;
+        }
+        if (t->sorted && (team_cursor_at(t, 0, &c) != 1 || team_cursor_insert(&c, 7, "Kurri") != 0)) {
+            passed = 0;
+        }
+        free_team(t);
+    }
+
+    team_config_t config;
+    config.flags = TEAM_UNROLLED;
+    team_t* unrolled = create_team_with(&config);
+    team_t* empty = create_team();
+    team_cursor_t c = {NULL, NULL, 0};
+    if (team_cursor_at(unrolled, 0, &c) != 0 || team_cursor_at(NULL, 0, &c) != -1 ||
+        team_cursor_at(empty, 1, &c) != 0 || team_cursor_next(NULL) != -1 ||
+        team_cursor_insert(NULL, 1, "x") != -1 || team_cursor_at(empty, 0, &c) != 1) {
+        free_team(unrolled);
+        free_team(empty);
+        return 0;
+    }
+    if (team_cursor_previous(&c) != 0 || team_cursor_player(&c) != NULL) {
+        passed = 0;
+    }
+    team_cursor_insert(&c, 2, "Krushelnyski");
+    team_cursor_previous(&c);
+    team_cursor_insert(&c, 1, "Hunter");
+    if (team_list_get(empty, 0) != 1 || team_list_get(empty, 1) != 2 || c.pos != 1 ||
+        team_cursor_player(&c) != empty->tail) {
+        passed = 0;
+    }
+    free_team(unrolled);
+    free_team(empty);
+
+    return passed;
+}
+
+//Tests that pooled players carved after a bulk push still belong to
+//the slab allocation they were carved out of.
+int unitTest60(int status) {
+    int passed = 1;
+    team_config_t config;
+    config.flags = TEAM_POOLED;
+    team_t* t = create_team_with(&config);
+    int i;
+    for (i = 0; i < 1500; i++) {
+        team_push_back(t, i, "Beukeboom");
+    }
+    team_slab_t* block = team_slab_of(t->tail)->owner;
+
+    int rosters[TEAM_BULK_MIN];
+    char* names[TEAM_BULK_MIN];
+    for (i = 0; i < TEAM_BULK_MIN; i++) {
+        rosters[i] = i;
+        names[i] = "Muni";
+    }
+    team_push_back_bulk(t, TEAM_BULK_MIN, rosters, names);
+    if (t->pool->slabs == block) {
+        passed = 0;
+    }
+
+    // the rest of the 1500 fill the second slab of the same allocation
+    for (i = 0; i < 1500; i++) {
+        team_push_back(t, i, "Beukeboom");
+    }
+    if (team_slab_of(t->tail)->owner != block || team_slab_of(t->tail) == block) {
+        passed = 0;
+    }
+    free_team(t);
+
+    return passed;
+}
+
+//Tests that a pooled team only keeps players of its own pool for reuse,
+//and frees malloc'd and bulk block players handed to it instead.
+int unitTest61(int status) {
+    int passed = 1;
+    team_config_t config;
+    config.flags = TEAM_POOLED;
+    team_t* pooled = create_team_with(&config);
+    team_t* plain = create_team();
+    int rosters[TEAM_BULK_MIN];
+    char* names[TEAM_BULK_MIN];
+    int i;
+    for (i = 0; i < TEAM_BULK_MIN; i++) {
+        rosters[i] = i;
+        names[i] = "Dave Semenko, left wing";
+    }
+    team_push_back_bulk(plain, TEAM_BULK_MIN, rosters, names);
+    team_push_back(pooled, 1, "Fuhr");
+
+    player_t* bulk = team_pop_back(plain);
+    if (!(bulk->flags & PLAYER_NODE_BLOCK) ||
+        team_recycle_player(pooled, create_player(5, "Kevin Lowe, defence")) != 1 ||
+        team_recycle_player(pooled, bulk) != 1 || pooled->spareCount != 0) {
+        passed = 0;
+    }
+    team_recycle_player(pooled, team_pop_back(pooled));
+    team_push_back(pooled, 31, "Grant Fuhr, goaltender");
+    if (pooled->spareCount != 0 || !(pooled->tail->flags & PLAYER_NODE_POOL)) {
+        passed = 0;
+    }
+
+    free_team(plain);
+    free_team(pooled);
+
+    return passed;
+}
+
 // An array of function pointers to all of the tests
 // that main() can use iterate over them.
 int (*unitTests[])(int)={
@@ -619,6 +2623,45 @@ int (*unitTests[])(int)={
     unitTest20,
     unitTest21,
     unitTest22,
+    unitTest23,
+    unitTest24,
+    unitTest25,
+    unitTest26,
+    unitTest27,
+    unitTest28,
+    unitTest29,
+    unitTest30,
+    unitTest31,
+    unitTest32,
+    unitTest33,
+    unitTest34,
+    unitTest35,
+    unitTest36,
+    unitTest37,
+    unitTest38,
+    unitTest39,
+    unitTest40,
+    unitTest41,
+    unitTest42,
+    unitTest43,
+    unitTest44,
+    unitTest45,
+    unitTest46,
+    unitTest47,
+    unitTest48,
+    unitTest49,
+    unitTest50,
+    unitTest51,
+    unitTest52,
+    unitTest53,
+    unitTest54,
+    unitTest55,
+    unitTest56,
+    unitTest57,
+    unitTest58,
+    unitTest59,
+    unitTest60,
+    unitTest61,
     NULL
 };
 
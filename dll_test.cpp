@@ -0,0 +1,231 @@
+// test suite for the C++ doubly linked list
+//
+// Build and run with
+//     g++ -std=c++17 -pthread -o dll_test_cpp dll_test.cpp dll_test_link.cpp && ./dll_test_cpp
+//
+// dll_test_link.cpp includes the headers too, so a duplicate definition
+// anywhere in them fails the link. This file defines the hazard pointer
+// registry of my_dll_concurrent.h for both.
+#include <cstdio>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include "my_dll.hpp"
+#define MYDLL_CONCURRENT_IMPLEMENTATION
+#include "my_dll_concurrent.h"
+
+// Bookkeeping left out by a policy takes no room.
+static_assert(sizeof(mydll::dll<int, std::allocator<int>, mydll::uncounted_without_tail>) == sizeof(void*),
+              "an uncounted dll without a tail is just its head");
+static_assert(sizeof(mydll::dll<int>) == 3 * sizeof(void*), "a counted dll with a tail keeps both");
+static_assert(std::is_same<std::iterator_traits<mydll::dll<int>::iterator>::iterator_category,
+                           std::bidirectional_iterator_tag>::value, "dll iterators are bidirectional");
+
+// Helper for the allocator test
+// Counts the nodes it hands out, each copy of it shares the counter.
+template <typename T>
+struct countingAllocator {
+    using value_type = T;
+    long* live;
+
+    explicit countingAllocator(long* counter) : live(counter) {}
+    template <typename U>
+    countingAllocator(const countingAllocator<U>& other) : live(other.live) {}
+
+    T* allocate(std::size_t n) {
+        *live += n;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, std::size_t n) {
+        *live -= n;
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const countingAllocator<U>& other) const { return live == other.live; }
+    template <typename U>
+    bool operator!=(const countingAllocator<U>& other) const { return live != other.live; }
+};
+
+// Tests emplacing move-only payloads at both ends and walking them with
+// iterators, reverse iterators and standard algorithms.
+int unitTest0(int status) {
+    int passed = 1;
+    mydll::dll<std::unique_ptr<int>> list;
+    int i;
+    for (i = 0; i < 10; i++) {
+        if (i % 2 == 0) {
+            list.emplace_back(new int(i));
+        }
+        else {
+            list.emplace_front(std::make_unique<int>(i));
+        }
+    }
+
+    std::vector<int> forward;
+    for (const auto& value : list) {
+        forward.push_back(*value);
+    }
+    std::vector<int> backward;
+    for (auto it = list.rbegin(); it != list.rend(); ++it) {
+        backward.push_back(**it);
+    }
+    std::reverse(backward.begin(), backward.end());
+
+    auto seven = std::find_if(list.begin(), list.end(), [](const std::unique_ptr<int>& p) { return *p == 7; });
+    if (list.size() != 10 || forward != std::vector<int>({9, 7, 5, 3, 1, 0, 2, 4, 6, 8}) ||
+        backward != forward || std::distance(list.begin(), seven) != 1 ||
+        *list.front() != 9 || *list.back() != 8) {
+        passed = 0;
+    }
+
+    list.pop_front();
+    list.pop_back();
+    if (list.size() != 8 || *list.front() != 7 || *list.back() != 6) {
+        passed = 0;
+    }
+
+    return passed;
+}
+
+// Tests inserting and erasing in the middle and moving lists, for every
+// policy.
+template <typename Policy>
+int policyWorks() {
+    mydll::dll<std::string, std::allocator<std::string>, Policy> list;
+    list.emplace_front("Messier");
+    list.emplace_front("Gretzky");
+    auto it = list.emplace(std::next(list.begin()), 5, 'K');
+    list.emplace(list.end(), "Coffey");
+
+    auto last = std::prev(list.end());
+    if (*it != "KKKKK" || *last != "Coffey" || list.size() != 4) {
+        return 0;
+    }
+
+    it = list.erase(it);
+    auto moved = std::move(list);
+    if (*it != "Messier" || !list.empty() || list.size() != 0 || moved.size() != 3 ||
+        moved.front() != "Gretzky" || *std::prev(moved.end()) != "Coffey") {
+        return 0;
+    }
+
+    list = std::move(moved);
+    list.erase(list.begin());
+    list.erase(std::prev(list.end()));
+    return list.size() == 1 && list.front() == "Messier" && moved.empty();
+}
+
+int unitTest1(int status) {
+    return policyWorks<mydll::counted_with_tail>() && policyWorks<mydll::uncounted_with_tail>() &&
+           policyWorks<mydll::counted_without_tail>() && policyWorks<mydll::uncounted_without_tail>();
+}
+
+// Tests that nodes come from the given allocator and all go back to it.
+int unitTest2(int status) {
+    int passed = 1;
+    long live = 0;
+    {
+        countingAllocator<int> alloc(&live);
+        mydll::dll<int, countingAllocator<int>> list(alloc);
+        int i;
+        for (i = 0; i < 100; i++) {
+            list.emplace_back(i);
+        }
+        list.erase(std::find(list.begin(), list.end(), 50));
+        if (live != 99 || list.get_allocator().live != &live) {
+            passed = 0;
+        }
+    }
+
+    return passed && live == 0;
+}
+
+// Tests the team_t wrapper: pushes, iteration and popped players.
+int unitTest3(int status) {
+    int passed = 1;
+    team_config_t config;
+    config.flags = TEAM_SKIPLIST;
+    mydll::team t(&config);
+    t.push_back(99, "Gretzky");
+    t.push_back(17, "Kurri");
+    t.push_front(11, "Messier");
+
+    int sum = 0;
+    for (const player_t& p : t) {
+        sum += p.rosterNum;
+    }
+    mydll::team::player_ptr last = t.pop_back();
+    if (sum != 127 || last == nullptr || std::string(last->name) != "Kurri" ||
+        t.size() != 2 || std::prev(t.end())->rosterNum != 99 ||
+        team_list_get(t.get(), 0) != 11) {
+        passed = 0;
+    }
+
+    mydll::team moved(std::move(t));
+    if (t.get() != nullptr || moved.size() != 2 || t.begin() != t.end()) {
+        passed = 0;
+    }
+
+    return passed;
+}
+
+int linkedSizes(team_lockfree_t* shared);
+
+// Tests that a team and a dll built in another file of the program work,
+// with the headers included in both files, and that a lock-free team is
+// shared between them.
+int unitTest4(int status) {
+    int passed = 1;
+    mydll::team t;
+    t.push_back(9, "Howe");
+    team_lockfree_t* shared = create_team_lockfree();
+    team_lockfree_push_back(shared, 2, const_cast<char*>("Shore"));
+    if (linkedSizes(shared) != 3 || t.size() != 1 || team_lockfree_size(shared) != 2) {
+        passed = 0;
+    }
+    player_t* first = team_lockfree_pop_front(shared);
+    player_t* second = team_lockfree_pop_front(shared);
+    if (first == nullptr || first->rosterNum != 2 || second == nullptr || second->rosterNum != 16) {
+        passed = 0;
+    }
+    free_player(first);
+    free_player(second);
+    free_team_lockfree(shared);
+
+    return passed;
+}
+
+// An array of function pointers to all of the tests
+// that main() can use iterate over them.
+int (*unitTests[])(int) = {
+    unitTest0,
+    unitTest1,
+    unitTest2,
+    unitTest3,
+    unitTest4,
+    NULL
+};
+
+int main() {
+    unsigned int testsPassed = 0;
+    int counter = 0;
+    while (unitTests[counter] != NULL) {
+        printf("========unitTest %d========\n", counter);
+        if (1 == unitTests[counter](1)) {
+            printf("passed test\n");
+            testsPassed++;
+        }
+        else {
+            printf("failed test, missing functionality, or incorrect test\n");
+        }
+        counter++;
+    }
+
+    printf("%d of %d tests passed\n", testsPassed, counter);
+
+    return 0;
+}
@@ -0,0 +1,22 @@
+// second translation unit of the C++ test suite
+//
+// Includes my_dll.hpp and my_dll_concurrent.h again so the test build
+// checks that the headers can be used from more than one file of a
+// program, see dll_test.cpp.
+#include "my_dll.hpp"
+#include "my_dll_concurrent.h"
+
+// Helper for the linking test
+// Builds a team and a dll in this file and returns their sizes added up,
+// after pushing a player onto shared from here.
+int linkedSizes(team_lockfree_t* shared) {
+    mydll::team t;
+    t.push_back(4, "Orr");
+    t.push_back(7, "Esposito");
+
+    mydll::dll<int> numbers;
+    numbers.emplace_back(77);
+    team_lockfree_push_back(shared, 16, const_cast<char*>("Clarke"));
+
+    return static_cast<int>(t.size() + numbers.size());
+}
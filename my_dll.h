@@ -2,29 +2,418 @@
 // Doubly Linked List
 //
 // Create a working DLL that represents a hockey team.
+//
+// Every function is static inline, so any number of files of a program
+// can include the header.
 // ==================================================
 #ifndef MYDLL_H
 #define MYDLL_H
 
+// clock_gettime is POSIX, strict ISO C builds have to ask for it.
+#if defined(TEAM_STATS) && defined(__STRICT_ANSI__) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#ifdef TEAM_STATS
+#include <time.h>
+#endif
+
+// Lets C++ code include the header too, see my_dll.hpp.
+#ifdef __cplusplus
+#define TEAM_ALIGNOF(type) alignof(type)
+extern "C" {
+#else
+#define TEAM_ALIGNOF(type) _Alignof(type)
+#endif
+
+// Pool slabs are allocated aligned to their own size so a player can find
+// its slab (and through it, its pool) by masking its address.
+#define TEAM_SLAB_BYTES 65536
+#define TEAM_ARENA_BYTES 65536
+
+// A pool allocates its slabs in blocks and its name arena in chunks that
+// double in size up to these limits, so a team of millions of players
+// lives in a few hundred allocations that team_clear and free_team give
+// back in as many frees.
+#define TEAM_POOL_MAX_SLABS 64
+#define TEAM_ARENA_MAX_BYTES (64 * TEAM_ARENA_BYTES)
+
+// Names shorter than this are stored inside the player itself, which keeps
+// a player_t in one 64 byte cache line and saves the name allocation.
+#define PLAYER_INLINE_NAME 24
+
+// Most lanes a skip list tower can have, each lane up skips about four
+// times as many players as the one below it.
+#define TEAM_SKIP_LEVELS 16
+
+// Bulk pushes of fewer players than this just push them one by one.
+#define TEAM_BULK_MIN 32
+
+// Players held by one chunk of an unrolled team.
+#define TEAM_CHUNK_PLAYERS 16
+
+// Players team_recycle_player keeps for reuse by default, see
+// team_recycle_limit.
+#define TEAM_RECYCLE_LIMIT 64
+
+// player_t flags: where the node and its name were allocated from.
+// A player with no flags set was malloc'd, with its name either inline or
+// malloc'd on its own when it is too long.
+#define PLAYER_NODE_POOL 0x01	// node lives in a team pool slab
+#define PLAYER_NAME_ARENA 0x02	// name lives in a pool name arena, a bulk block or its mapping
+#define PLAYER_NODE_BLOCK 0x04	// node lives in a reference counted bulk block
+#define PLAYER_NAME_INTERNED 0x08	// name is shared through a team_names_t table
+
+// team_config_t flags
+#define TEAM_POOLED 0x01	// allocate players and names from a per-team pool
+#define TEAM_INDEXED 0x02	// keep a rosterNum -> player hash index
+#define TEAM_SKIPLIST 0x04	// keep skip list express lanes for O(log n) positions
+#define TEAM_UNROLLED 0x08	// store players in chunks instead of player_t nodes
+#define TEAM_COMPACT 0x10	// store players in parallel arrays linked by index
+#define TEAM_SORTED 0x20	// keep players in rosterNum order, implies TEAM_SKIPLIST
+
+// team_t storage backends
+#define TEAM_STORAGE_LINKED 0	// one player_t node per player
+#define TEAM_STORAGE_UNROLLED 1	// unrolled list of team_chunk_t
+#define TEAM_STORAGE_COMPACT 2	// team_slots_t parallel arrays
+
+// Index standing for no slot in a compact team.
+#define TEAM_NO_SLOT UINT32_MAX
+
+// team_sort keys
+#define TEAM_SORT_ROSTER 0	// by rosterNum
+#define TEAM_SORT_NAME 1	// by name, as strcmp orders them
+
+// Sorted runs team_sort keeps on the side, run i holds 2^i players.
+#define TEAM_SORT_RUNS 32
+
+// team_* operations counted by team_stats when built with TEAM_STATS.
+#define TEAM_OP_PUSH_FRONT 0
+#define TEAM_OP_PUSH_BACK 1
+#define TEAM_OP_POP_FRONT 2
+#define TEAM_OP_POP_BACK 3
+#define TEAM_OP_INSERT 4
+#define TEAM_OP_LIST_GET 5
+#define TEAM_OP_LIST_REMOVE 6
+#define TEAM_OP_PUSH_BULK 7	// team_push_back_bulk and team_push_front_bulk
+#define TEAM_OP_FIND_BY_ROSTER 8
+#define TEAM_OP_REMOVE_BY_ROSTER 9
+#define TEAM_OP_SPLICE 10
+#define TEAM_OP_SPLIT 11
+#define TEAM_OP_SORT 12
+#define TEAM_OP_INSERT_SORTED 13
+#define TEAM_OP_LOWER_BOUND 14	// team_lower_bound and team_range
+#define TEAM_OP_CURSOR 15	// team_cursor_insert and team_cursor_remove
+#define TEAM_OP_COUNT 16
+
+// Buckets of the team_stats histograms. Bucket 0 counts zeros and bucket
+// b counts values from 2^(b-1) up to 2^b - 1, the last one everything
+// larger.
+#define TEAM_STATS_BUCKETS 32
+
 // define a struct for the nodes of the DLL to represent a hockey player
 typedef struct player {
     int rosterNum;
+    unsigned char flags;	// PLAYER_* allocation flags
     char* name;
     struct player* next;
     struct player* previous;
+    char inlineName[PLAYER_INLINE_NAME];	// name storage for short names
+    struct team_tower* tower;	// skip list tower, NULL if the player has none
 } player_t;
 
+// Header at the start of every pool slab, followed by player_t blocks.
+// Pools allocate several slabs at a time, and a bulk block is several
+// slabs in one allocation too, with the names of its players packed after
+// the last slab or left in a mapping it holds on to.
+typedef struct team_slab {
+    struct team_pool* pool;	// pool the slab belongs to, NULL for a bulk block of an unpooled team
+    struct team_slab* nextSlab;	// next slab owned by the same pool
+    struct team_slab* owner;	// first slab of the allocation this slab is part of
+    long live;			// players of an unpooled bulk block not yet freed, kept in owner, updated atomically
+    void* mapping;		// memory the names of a bulk block point into, NULL if none
+    size_t mappingSize;
+    void (*unmap)(void* mapping, size_t size);	// releases mapping along with the block
+} team_slab_t;
+
+// One chunk of a pool's name arena, names are bump-allocated out of bytes.
+typedef struct team_arena_chunk {
+    struct team_arena_chunk* nextChunk;
+    size_t used;
+    size_t size;
+    char bytes[];
+} team_arena_chunk_t;
+
+// A per-team node pool: fixed-size player_t blocks carved out of slabs
+// plus a bump arena for the names. Everything is released by free_team
+// of the last team using the pool.
+typedef struct team_pool {
+    team_slab_t* slabs;		// first slab of every allocation owned by the pool
+    player_t* freePlayers;	// players given back by free_player, linked by next
+    char* bump;			// next unused player block in the current slab
+    char* bumpEnd;		// end of the current slab
+    team_slab_t* block;		// newest slab allocation, the slabs of bulk blocks aside
+    char* blockEnd;		// end of block
+    int blockSlabs;		// slabs in the newest slab allocation
+    size_t arenaBytes;		// size of the newest regular name chunk
+    team_arena_chunk_t* names;	// name arena chunks, newest first
+    int teams;			// teams sharing the pool, see team_split
+} team_pool_t;
+
+// One name of an intern table, shared by every player carrying it.
+typedef struct team_name {
+    struct team_name* next;	// next name in the same bucket
+    struct team_names* table;	// table holding the name
+    unsigned int hash;
+    long refs;			// players using the name
+    char text[];		// the name players point at
+} team_name_t;
+
+// A table of interned names that any number of teams can share, see
+// team_use_names. Each distinct name is stored once and counts the
+// players using it, so players with equal names have equal name pointers.
+// The table goes once free_team_names was called, no team uses it and
+// no player holds one of its names. Not safe to use from several threads
+// at once.
+typedef struct team_names {
+    team_name_t** buckets;	// chains of names by hash
+    int bits;			// there are 1 << bits buckets, 0 before the first name
+    int count;			// names held
+    int users;			// teams using the table, plus one until free_team_names
+} team_names_t;
+
+// Open addressing hash index from rosterNum to the players carrying it.
+// Players sharing a roster number each get their own slot.
+typedef struct team_index {
+    player_t** slots;	// NULL marks an empty slot
+    int bits;		// the table has 1 << bits slots
+    int used;		// slots holding a player
+} team_index_t;
+
+// One express lane of a skip list tower.
+typedef struct team_lane {
+    struct team_tower* next;	// next tower on this lane, NULL for the last one
+    struct team_tower* previous;	// previous tower on this lane or the header
+    int span;		// stored span, read it through team_skip_span
+} team_lane_t;
+
+// A skip list tower standing on one player of the chain. The player chain
+// itself is the bottom level, lanes[0] is the first express lane above it.
+typedef struct team_tower {
+    player_t* player;	// NULL for the header
+    int height;		// number of lanes
+    team_lane_t lanes[];
+} team_tower_t;
+
+// Span counted skip list over the player chain. The span of a lane is
+// the number of positions to the next tower on it, or for the last tower
+// the number of positions to the end of the team. The header sits at
+// position -1. Pushes and pops at either end would change every header
+// span or every last span, so those changes are kept in frontShift and
+// backShift instead.
+typedef struct team_skiplist {
+    team_tower_t* header;	// tower with every lane, before the first player
+    team_tower_t* laneTail[TEAM_SKIP_LEVELS];	// last tower on each lane
+    int level;		// lanes in use
+    int frontShift;	// added to every span of the header
+    int backShift;	// added to the span of the last tower of every lane
+    uint32_t seed;	// xorshift state for tower heights
+} team_skiplist_t;
+
+// One chunk of an unrolled team: up to TEAM_CHUNK_PLAYERS players stored
+// side by side, so scans touch consecutive memory instead of one node per
+// player. Chunks are split when full and merged when they run low.
+typedef struct team_chunk {
+    struct team_chunk* next;
+    struct team_chunk* previous;
+    int count;				// players in use, from index 0
+    int rosterNums[TEAM_CHUNK_PLAYERS];
+    char* names[TEAM_CHUNK_PLAYERS];	// malloc'd copies of the names
+} team_chunk_t;
+
+// Storage of a compact team: slot i of every array describes one player
+// and players link to each other by 32 bit slot index, so a player costs
+// 20 bytes plus its name and the whole team can be moved or written out
+// without fixing up pointers. Unused slots are chained through next.
+typedef struct team_slots {
+    uint32_t* next;
+    uint32_t* previous;
+    int* rosterNums;
+    char** names;		// malloc'd copies of the names
+    uint32_t capacity;		// slots in each array
+    uint32_t head;		// first player, TEAM_NO_SLOT if none
+    uint32_t tail;		// last player, TEAM_NO_SLOT if none
+    uint32_t freeSlot;		// first unused slot, TEAM_NO_SLOT if none
+    uint32_t cursor;		// slot last reached by position, TEAM_NO_SLOT if unknown
+} team_slots_t;
+
+// Counters of one team_* operation. Calls made by other team_* functions
+// count too, team_insert at the end is also a team_push_back.
+typedef struct team_op_stats {
+    unsigned long calls;
+    unsigned long hops;		// players, chunks, lanes and probes stepped over
+    unsigned long long nanos;	// time spent in the calls
+    unsigned long hopHistogram[TEAM_STATS_BUCKETS];	// calls by hops
+    unsigned long nanoHistogram[TEAM_STATS_BUCKETS];	// calls by nanoseconds
+} team_op_stats_t;
+
+// Everything team_stats reports about one team.
+typedef struct team_stats {
+    team_op_stats_t ops[TEAM_OP_COUNT];	// by TEAM_OP_*
+    unsigned long players;	// players created for the team
+    unsigned long allocations;	// memory blocks allocated for the team
+    unsigned long hops;		// running total of hops, for the operation scopes
+} team_stats_t;
+
+// Options for create_team_with.
+typedef struct team_config {
+    int flags;		// TEAM_* flags
+} team_config_t;
+
 // define a struct for the DLL to represent the whole hockey team
 typedef struct Team {
     int activePlayers;		// count keeps track of how many active players are on the Team.
     player_t* head;		// head points to the first player node in our DLL.
     player_t* tail;          //tail points to the last player node in our DLL.
+    team_pool_t* pool;		// node pool, NULL when players are malloc'd one by one.
+    team_index_t* index;	// rosterNum index, NULL when the team is not indexed.
+    team_skiplist_t* skip;	// express lanes, NULL when the team has no skip list.
+    player_t* cursor;		// last player reached by position, NULL if unknown.
+    int cursorPos;		// position of cursor.
+    int storage;		// TEAM_STORAGE_* backend, head and tail stay NULL if not linked.
+    team_chunk_t* firstChunk;	// first chunk of an unrolled team.
+    team_chunk_t* lastChunk;	// last chunk of an unrolled team.
+    team_chunk_t* cursorChunk;	// chunk last reached by position, NULL if unknown.
+    int cursorChunkPos;		// position of the first player in cursorChunk.
+    team_slots_t* slots;	// arrays of a compact team, NULL if not compact.
+    int sorted;			// 1 if players are kept in rosterNum order, see TEAM_SORTED.
+    team_names_t* names;	// intern table for player names, NULL if names are copied.
+    player_t* spare;		// players kept by team_recycle_player, linked by next.
+    int spareCount;		// players on spare.
+    int spareLimit;		// most players spare may hold.
+#ifdef TEAM_STATS
+    team_stats_t* stats;	// operation counters, see team_stats.
+#endif
 } team_t;
 
-// Creates a Team 
+// A place on a linked team to edit it from in a single pass: on a player,
+// or past the last one. Moving it, inserting before its player and
+// removing its player take O(1), O(log n) on a skip listed team, instead
+// of walking to a position every time. The cursor stays valid across its
+// own edits. Other changes to the team leave its position out of date,
+// and removing its player by other means leaves it dangling.
+typedef struct team_cursor {
+    team_t* team;
+    player_t* player;	// player the cursor is on, NULL past the last one
+    int pos;		// position of player, the team size past the last one
+} team_cursor_t;
+
+#ifdef TEAM_STATS
+// An operation being timed, recorded into the team when it goes out of
+// scope so every return of the operation is covered.
+typedef struct team_stat_scope {
+    team_t* t;			// NULL if there is nothing to record into
+    int op;
+    long long start;		// nanoseconds
+    unsigned long hops;		// t->stats->hops when the operation started
+} team_stat_scope_t;
+
+// Helper function
+// Returns the histogram bucket of value.
+static inline int team_stat_bucket(unsigned long long value) {
+
+    if (value == 0) {
+        return 0;
+    }
+    int bucket = 64 - __builtin_clzll(value);
+    return bucket < TEAM_STATS_BUCKETS ? bucket : TEAM_STATS_BUCKETS - 1;
+}
+
+// Helper function
+// Returns a timestamp in nanoseconds from the monotonic clock, or from
+// clock() if a system header included before this one left the POSIX
+// clocks out.
+static inline long long team_stat_now() {
+
+#ifdef CLOCK_MONOTONIC
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#else
+    return (long long)clock() * (1000000000LL / CLOCKS_PER_SEC);
+#endif
+}
+
+// Helper function
+// Starts timing operation op on t, which may be NULL.
+static inline team_stat_scope_t team_stat_enter(team_t* t, int op) {
+
+    team_stat_scope_t scope;
+    scope.t = t;
+    scope.op = op;
+    scope.start = team_stat_now();
+    scope.hops = t != NULL ? t->stats->hops : 0;
+    return scope;
+}
+
+// Helper function
+// Records the operation of scope into its team.
+static inline void team_stat_leave(team_stat_scope_t* scope) {
+
+    if (scope->t == NULL) {
+        return;
+    }
+
+    long long nanos = team_stat_now() - scope->start;
+    unsigned long hops = scope->t->stats->hops - scope->hops;
+
+    team_op_stats_t* op = &scope->t->stats->ops[scope->op];
+    op->calls++;
+    op->hops += hops;
+    op->nanos += nanos;
+    op->hopHistogram[team_stat_bucket(hops)]++;
+    op->nanoHistogram[team_stat_bucket(nanos)]++;
+}
+
+// Times the rest of the enclosing function as operation op of t.
+#define TEAM_STAT_OP(t, op) \
+    team_stat_scope_t teamStatScope __attribute__((cleanup(team_stat_leave))) = team_stat_enter(t, op)
+// Counts n hops of the running operation of t.
+#define TEAM_STAT_HOPS(t, n) ((t)->stats->hops += (n))
+// Counts n players created and n allocations made for t.
+#define TEAM_STAT_PLAYERS(t, n) ((t)->stats->players += (n))
+#define TEAM_STAT_ALLOC(t, n) ((t)->stats->allocations += (n))
+#else
+// Without TEAM_STATS the counters compile away.
+#define TEAM_STAT_OP(t, op)
+#define TEAM_STAT_HOPS(t, n)
+#define TEAM_STAT_PLAYERS(t, n)
+#define TEAM_STAT_ALLOC(t, n)
+#endif
+
+static inline void free_player(player_t* p);
+static inline void free_team(team_t* t);
+
+// Creates a Team configured by config, a NULL config gives the defaults.
+// Unrolled and compact teams cannot also be pooled, indexed, skip listed
+// or sorted, nor both at once. Sorted teams always get a skip list.
 // Returns a pointer to a newly created Team.
-// Returns NULL if we could not allocate memory.
-team_t* create_team(){
+// Returns NULL if we could not allocate memory or the flags conflict.
+static inline team_t* create_team_with(const team_config_t* config){
+
+    int flags = config != NULL ? config->flags : 0;
+    if (flags & TEAM_SORTED) {
+        flags |= TEAM_SKIPLIST;
+    }
+    if ((flags & (TEAM_UNROLLED | TEAM_COMPACT)) &&
+        (flags & (TEAM_POOLED | TEAM_INDEXED | TEAM_SKIPLIST))) {
+        return NULL;
+    }
+    if ((flags & TEAM_UNROLLED) && (flags & TEAM_COMPACT)) {
+        return NULL;
+    }
 
     team_t* myTeam= (team_t*)malloc(sizeof(team_t));
     if (myTeam == NULL) {
@@ -34,340 +423,3333 @@ team_t* create_team(){
     myTeam->activePlayers = 0;
     myTeam->head = NULL;
     myTeam->tail = NULL;
+    myTeam->pool = NULL;
+    myTeam->index = NULL;
+    myTeam->skip = NULL;
+    myTeam->cursor = NULL;
+    myTeam->cursorPos = 0;
+    myTeam->storage = TEAM_STORAGE_LINKED;
+    myTeam->firstChunk = NULL;
+    myTeam->lastChunk = NULL;
+    myTeam->cursorChunk = NULL;
+    myTeam->cursorChunkPos = 0;
+    myTeam->slots = NULL;
+    myTeam->sorted = (flags & TEAM_SORTED) != 0;
+    myTeam->names = NULL;
+    myTeam->spare = NULL;
+    myTeam->spareCount = 0;
+    myTeam->spareLimit = TEAM_RECYCLE_LIMIT;
+
+    if (config != NULL && (config->flags & TEAM_UNROLLED)) {
+        myTeam->storage = TEAM_STORAGE_UNROLLED;
+    }
+
+    if (config != NULL && (config->flags & TEAM_COMPACT)) {
+        myTeam->slots = (team_slots_t*)calloc(1, sizeof(team_slots_t));
+        if (myTeam->slots == NULL) {
+            free(myTeam);
+            return NULL;
+        }
+        myTeam->slots->head = TEAM_NO_SLOT;
+        myTeam->slots->tail = TEAM_NO_SLOT;
+        myTeam->slots->freeSlot = TEAM_NO_SLOT;
+        myTeam->slots->cursor = TEAM_NO_SLOT;
+        myTeam->storage = TEAM_STORAGE_COMPACT;
+    }
+
+    if (config != NULL && (config->flags & TEAM_POOLED)) {
+        myTeam->pool = (team_pool_t*)calloc(1, sizeof(team_pool_t));
+        if (myTeam->pool == NULL) {
+            free(myTeam);
+            return NULL;
+        }
+        myTeam->pool->teams = 1;
+    }
+
+    if (config != NULL && (config->flags & TEAM_INDEXED)) {
+        myTeam->index = (team_index_t*)calloc(1, sizeof(team_index_t));
+        if (myTeam->index == NULL) {
+            free(myTeam->pool);
+            free(myTeam);
+            return NULL;
+        }
+    }
+
+    if (flags & TEAM_SKIPLIST) {
+        myTeam->skip = (team_skiplist_t*)calloc(1, sizeof(team_skiplist_t));
+        if (myTeam->skip != NULL) {
+            myTeam->skip->header = (team_tower_t*)calloc(1, sizeof(team_tower_t) + TEAM_SKIP_LEVELS * sizeof(team_lane_t));
+        }
+        if (myTeam->skip == NULL || myTeam->skip->header == NULL) {
+            free(myTeam->skip);
+            free(myTeam->index);
+            free(myTeam->pool);
+            free(myTeam);
+            return NULL;
+        }
+        myTeam->skip->header->height = TEAM_SKIP_LEVELS;
+        myTeam->skip->seed = 2463534242u;
+    }
+
+#ifdef TEAM_STATS
+    myTeam->stats = (team_stats_t*)calloc(1, sizeof(team_stats_t));
+    if (myTeam->stats == NULL) {
+        free_team(myTeam);
+        return NULL;
+    }
+#endif
 
     return myTeam;
 }
 
+// Creates a Team 
+// Returns a pointer to a newly created Team.
+// Returns NULL if we could not allocate memory.
+static inline team_t* create_team(){
 
+    return create_team_with(NULL);
+}
 
-// Check if the team is empty
-// Returns -1 if the team is NULL.
-// Returns 1 if true (The team is completely empty)
-// Returns 0 if false (the team DLL has at least one player enqueued)
-int team_empty(team_t* t){
+// Helper function
+// Returns the slab a pooled player was carved out of.
+static inline team_slab_t* team_slab_of(player_t* p) {
 
-    if (t == NULL) {
-        return -1;
+    return (team_slab_t*)((uintptr_t)p & ~(uintptr_t)(TEAM_SLAB_BYTES - 1));
+}
+
+// Helper function
+// Hands out one player block from the pool, reusing freed players first
+// and moving on to the next slab when the current one is used up. Each
+// new allocation holds twice as many slabs as the one before.
+// Returns NULL if we could not allocate memory.
+static inline player_t* team_pool_player(team_pool_t* pool) {
+
+    player_t* p = pool->freePlayers;
+    if (p != NULL) {
+        pool->freePlayers = p->next;
+        return p;
     }
-    else if (t->activePlayers == 0) {
-        return 1;
+
+    if (pool->bump == NULL || pool->bumpEnd - pool->bump < (long)sizeof(player_t)) {
+        team_slab_t* slab;
+        if (pool->bumpEnd != NULL && pool->bumpEnd != pool->blockEnd) {
+            slab = (team_slab_t*)pool->bumpEnd;
+            slab->owner = pool->block;
+        }
+        else {
+            int count = pool->blockSlabs < 1 ? 1 : pool->blockSlabs * 2;
+            if (count > TEAM_POOL_MAX_SLABS) {
+                count = TEAM_POOL_MAX_SLABS;
+            }
+            slab = (team_slab_t*)aligned_alloc(TEAM_SLAB_BYTES, count * (size_t)TEAM_SLAB_BYTES);
+            if (slab == NULL) {
+                return NULL;
+            }
+            slab->nextSlab = pool->slabs;
+            slab->owner = slab;
+            slab->mapping = NULL;
+            pool->slabs = slab;
+            pool->block = slab;
+            pool->blockSlabs = count;
+            pool->blockEnd = (char*)slab + count * (size_t)TEAM_SLAB_BYTES;
+        }
+        slab->pool = pool;
+
+        size_t first = (sizeof(team_slab_t) + TEAM_ALIGNOF(player_t) - 1) & ~(TEAM_ALIGNOF(player_t) - 1);
+        pool->bump = (char*)slab + first;
+        pool->bumpEnd = (char*)slab + TEAM_SLAB_BYTES;
     }
-    else if (t->activePlayers > 0){
+
+    p = (player_t*)pool->bump;
+    pool->bump += sizeof(player_t);
+    return p;
+}
+
+// Helper function
+// Bump-allocates size bytes from the pool name arena. Regular chunks
+// double in size, names too large for one get a chunk of their own.
+// Returns NULL if we could not allocate memory.
+static inline char* team_pool_bytes(team_pool_t* pool, size_t size) {
+
+    team_arena_chunk_t* chunk = pool->names;
+    if (chunk == NULL || chunk->size - chunk->used < size) {
+        // a pool emptied by team_clear starts again at the size it had reached
+        size_t regular = pool->arenaBytes;
+        if (regular == 0) {
+            regular = TEAM_ARENA_BYTES;
+        }
+        else if (chunk != NULL && regular < TEAM_ARENA_MAX_BYTES) {
+            regular *= 2;
+        }
+        int own = size > TEAM_ARENA_BYTES / 4;
+        size_t chunkSize = own ? size : regular;
+        team_arena_chunk_t* fresh = (team_arena_chunk_t*)malloc(sizeof(team_arena_chunk_t) + chunkSize);
+        if (fresh == NULL) {
+            return NULL;
+        }
+        fresh->used = 0;
+        fresh->size = chunkSize;
+
+        // keep bumping the current chunk if the big name went to its own one
+        if (chunk != NULL && own) {
+            fresh->nextChunk = chunk->nextChunk;
+            chunk->nextChunk = fresh;
+        }
+        else {
+            fresh->nextChunk = chunk;
+            pool->names = fresh;
+            if (!own) {
+                pool->arenaBytes = chunkSize;
+            }
+        }
+        chunk = fresh;
+    }
+
+    char* bytes = chunk->bytes + chunk->used;
+    chunk->used += size;
+    return bytes;
+}
+
+// Helper function
+// Frees a slab or bulk block, and the mapping a bulk block holds.
+static inline void team_slab_free(team_slab_t* slab) {
+
+    if (slab->mapping != NULL) {
+        slab->unmap(slab->mapping, slab->mappingSize);
+    }
+    free(slab);
+}
+
+// Helper function
+// Releases every slab and name chunk of a pool, leaving it empty but
+// growing its allocations from the sizes they had reached.
+static inline void team_pool_reset(team_pool_t* pool) {
+
+    while (pool->slabs != NULL) {
+        team_slab_t* next = pool->slabs->nextSlab;
+        team_slab_free(pool->slabs);
+        pool->slabs = next;
+    }
+
+    while (pool->names != NULL) {
+        team_arena_chunk_t* next = pool->names->nextChunk;
+        free(pool->names);
+        pool->names = next;
+    }
+
+    pool->freePlayers = NULL;
+    pool->bump = NULL;
+    pool->bumpEnd = NULL;
+    pool->block = NULL;
+    pool->blockEnd = NULL;
+    pool->blockSlabs /= 2;
+}
+
+// Helper function
+// Releases every slab and name chunk of a pool, and the pool itself.
+static inline void team_pool_free(team_pool_t* pool) {
+
+    team_pool_reset(pool);
+    free(pool);
+}
+
+// Helper function
+// Returns the FNV-1a hash of name.
+static inline unsigned int team_names_hash(char* name) {
+
+    unsigned int hash = 2166136261u;
+    for (; *name != '\0'; name++) {
+        hash = (hash ^ (unsigned char)*name) * 16777619u;
+    }
+    return hash;
+}
+
+// Helper function
+// Frees the table once nothing uses it any more, see team_names_t.
+static inline void team_names_check(team_names_t* names) {
+
+    if (names->users == 0 && names->count == 0) {
+        free(names->buckets);
+        free(names);
+    }
+}
+
+// Helper function
+// Doubles the buckets of the table, rehashing the names held.
+// Returns 0 if we could not allocate memory, the table is left as it was.
+static inline int team_names_grow(team_names_t* names) {
+
+    int bits = names->bits == 0 ? 6 : names->bits + 1;
+    team_name_t** buckets = (team_name_t**)calloc((size_t)1 << bits, sizeof(team_name_t*));
+    if (buckets == NULL) {
         return 0;
     }
 
-    return -1; 
+    unsigned int mask = (1u << bits) - 1;
+    unsigned int i;
+    for (i = 0; names->bits > 0 && i < (1u << names->bits); i++) {
+        team_name_t* entry = names->buckets[i];
+        while (entry != NULL) {
+            team_name_t* next = entry->next;
+            entry->next = buckets[entry->hash & mask];
+            buckets[entry->hash & mask] = entry;
+            entry = next;
+        }
+    }
+
+    free(names->buckets);
+    names->buckets = buckets;
+    names->bits = bits;
+    return 1;
 }
 
-// push a new player to the front of the DLL ( before the first player in the list).
-// Returns -1 if DLL is NULL.
+// Helper function
+// Returns the interned copy of name, adding it to the table if it is
+// new, with one more reference for the caller to give back through
+// team_names_release.
+// Returns NULL if we could not allocate memory.
+static inline char* team_names_intern(team_names_t* names, char* name) {
+
+    unsigned int hash = team_names_hash(name);
+    team_name_t* entry = NULL;
+    if (names->bits > 0) {
+        entry = names->buckets[hash & ((1u << names->bits) - 1)];
+    }
+    while (entry != NULL && (entry->hash != hash || strcmp(entry->text, name) != 0)) {
+        entry = entry->next;
+    }
+    if (entry != NULL) {
+        entry->refs++;
+        return entry->text;
+    }
+
+    if ((names->bits == 0 || names->count >= (1 << names->bits)) && !team_names_grow(names)) {
+        return NULL;
+    }
+    size_t nameSize = strlen(name);
+    entry = (team_name_t*)malloc(sizeof(team_name_t) + nameSize + 1);
+    if (entry == NULL) {
+        return NULL;
+    }
+    entry->table = names;
+    entry->hash = hash;
+    entry->refs = 1;
+    memcpy(entry->text, name, nameSize + 1);
+
+    unsigned int bucket = hash & ((1u << names->bits) - 1);
+    entry->next = names->buckets[bucket];
+    names->buckets[bucket] = entry;
+    names->count++;
+    return entry->text;
+}
+
+// Helper function
+// Gives back one reference to an interned name, taking the name out of
+// its table with the last one.
+static inline void team_names_release(char* name) {
+
+    team_name_t* entry = (team_name_t*)(name - offsetof(team_name_t, text));
+    if (--entry->refs > 0) {
+        return;
+    }
+
+    team_names_t* names = entry->table;
+    team_name_t** link = &names->buckets[entry->hash & ((1u << names->bits) - 1)];
+    while (*link != entry) {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+    free(entry);
+    names->count--;
+    team_names_check(names);
+}
+
+// Helper function
+// Returns the index slot a roster number hashes to.
+static inline unsigned int team_index_hash(team_index_t* index, int roster) {
+
+    return ((uint32_t)roster * 2654435769u) >> (32 - index->bits);
+}
+
+// Helper function
+// Places p in the first free slot of its probe sequence.
+// The table must have a free slot.
+static inline void team_index_place(team_index_t* index, player_t* p) {
+
+    unsigned int mask = (1u << index->bits) - 1;
+    unsigned int i = team_index_hash(index, p->rosterNum);
+    while (index->slots[i] != NULL) {
+        i = (i + 1) & mask;
+    }
+    index->slots[i] = p;
+}
+
+// Helper function
+// Makes room for extra more players, keeping the table at most half full.
 // Returns 1 on success
-// Returns 0 on failure
-int team_push_front(team_t* t, int roster, char* name){
+// Returns 0 if we could not allocate memory.
+static inline int team_index_reserve(team_index_t* index, int extra) {
 
-    if (t == NULL) {
-        return -1;
+    long needed = 2 * ((long)index->used + extra);
+    if (index->slots != NULL && needed <= (1L << index->bits)) {
+        return 1;
     }
 
-    player_t* newPlayer = (player_t*)malloc(sizeof(player_t));
-    if (newPlayer == NULL) {
-        return 0;
+    int bits = index->bits < 4 ? 4 : index->bits;
+    while ((1L << bits) < needed) {
+        bits++;
     }
-    newPlayer->rosterNum = roster;
 
-    int nameSize = strlen(name);
-    newPlayer->name = (char*)malloc(sizeof(char) * (nameSize+1));
-    if (newPlayer->name == NULL) {
+    player_t** oldSlots = index->slots;
+    int oldBits = index->bits;
+    index->slots = (player_t**)calloc((size_t)1 << bits, sizeof(player_t*));
+    if (index->slots == NULL) {
+        index->slots = oldSlots;
         return 0;
     }
-    strcpy(newPlayer->name, name);
+    index->bits = bits;
 
-    newPlayer->next = t->head;
-    newPlayer->previous = NULL;
+    if (oldSlots != NULL) {
+        long i;
+        for (i = 0; i < (1L << oldBits); i++) {
+            if (oldSlots[i] != NULL) {
+                team_index_place(index, oldSlots[i]);
+            }
+        }
+        free(oldSlots);
+    }
 
-    if (t->head != NULL) {
-        t->head->previous = newPlayer;
+    return 1;
+}
+
+// Helper function
+// Removes p from the index, shifting later players of the probe run back
+// so no tombstones are needed.
+static inline void team_index_drop(team_index_t* index, player_t* p) {
+
+    unsigned int mask = (1u << index->bits) - 1;
+    unsigned int i = team_index_hash(index, p->rosterNum);
+    while (index->slots[i] != p) {
+        i = (i + 1) & mask;
     }
-    
-    t->head = newPlayer;
-    if (t->activePlayers == 0) {
-        t->tail = newPlayer;
+
+    unsigned int hole = i;
+    for (i = (hole + 1) & mask; index->slots[i] != NULL; i = (i + 1) & mask) {
+        unsigned int home = team_index_hash(index, index->slots[i]->rosterNum);
+        // move the player back if its home slot is not between the hole and i
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            index->slots[hole] = index->slots[i];
+            hole = i;
+        }
+    }
+    index->slots[hole] = NULL;
+    index->used--;
+}
+
+// Helper function
+// Returns the span of lane of tower x, see team_skiplist_t.
+static inline int team_skip_span(team_skiplist_t* sl, team_tower_t* x, int lane) {
+
+    int span = x->lanes[lane].span;
+    if (x == sl->header) {
+        span += sl->frontShift;
+    }
+    if (x->lanes[lane].next == NULL) {
+        span += sl->backShift;
+    }
+    return span;
+}
+
+// Helper function
+// Sets the span of lane of tower x. Link the lane first, whether it is
+// the last one on the lane matters.
+static inline void team_skip_set_span(team_skiplist_t* sl, team_tower_t* x, int lane, int span) {
+
+    if (x == sl->header) {
+        span -= sl->frontShift;
+    }
+    if (x->lanes[lane].next == NULL) {
+        span -= sl->backShift;
+    }
+    x->lanes[lane].span = span;
+}
+
+// Helper function
+// Links tower into lane right after x.
+static inline void team_skip_link_after(team_skiplist_t* sl, team_tower_t* x, team_tower_t* tower, int lane) {
+
+    tower->lanes[lane].previous = x;
+    tower->lanes[lane].next = x->lanes[lane].next;
+    if (tower->lanes[lane].next != NULL) {
+        tower->lanes[lane].next->lanes[lane].previous = tower;
+    }
+    else {
+        sl->laneTail[lane] = tower;
+    }
+    x->lanes[lane].next = tower;
+}
+
+// Helper function
+// Unlinks tower from lane.
+static inline void team_skip_unlink_lane(team_skiplist_t* sl, team_tower_t* tower, int lane) {
+
+    team_tower_t* previous = tower->lanes[lane].previous;
+    previous->lanes[lane].next = tower->lanes[lane].next;
+    if (tower->lanes[lane].next != NULL) {
+        tower->lanes[lane].next->lanes[lane].previous = previous;
+    }
+    else {
+        sl->laneTail[lane] = previous;
+    }
+}
+
+// Helper function
+// Gives a player that was just linked a tower of random height, one in
+// four players gets a tower and each extra lane is one in four again.
+// size is the team size not counting p. Brings any lane coming into use
+// up as an empty lane of the header.
+// Returns the tower, or NULL if p gets no tower.
+static inline team_tower_t* team_skip_new_tower(team_skiplist_t* sl, player_t* p, int size) {
+
+    uint32_t r = sl->seed;
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    sl->seed = r;
+
+    int height = 0;
+    while ((r & 3) == 0 && height < TEAM_SKIP_LEVELS) {
+        height++;
+        r >>= 2;
+    }
+    if (height == 0) {
+        return NULL;
+    }
+
+    team_tower_t* tower = (team_tower_t*)malloc(sizeof(team_tower_t) + height * sizeof(team_lane_t));
+    if (tower == NULL) {
+        // the player just goes without express lanes
+        return NULL;
+    }
+    tower->player = p;
+    tower->height = height;
+
+    for (; sl->level < height; sl->level++) {
+        sl->header->lanes[sl->level].next = NULL;
+        sl->laneTail[sl->level] = sl->header;
+        team_skip_set_span(sl, sl->header, sl->level, size + 1);
+    }
+
+    return tower;
+}
+
+// Helper function
+// Fills update with the last tower before p on every lane in use, or the
+// header, and distance with how many positions each of them is before p.
+static inline void team_skip_path(team_skiplist_t* sl, player_t* p, team_tower_t** update, int* distance) {
+
+    team_tower_t* x = sl->header;
+    int d = 1;
+    player_t* iterator = p->previous;
+    while (iterator != NULL && iterator->tower == NULL) {
+        iterator = iterator->previous;
+        d++;
+    }
+    if (iterator != NULL) {
+        x = iterator->tower;
+    }
+
+    int lane;
+    for (lane = 0; lane < sl->level; lane++) {
+        while (x->height <= lane) {
+            team_tower_t* previous = x->lanes[x->height - 1].previous;
+            d += team_skip_span(sl, previous, x->height - 1);
+            x = previous;
+        }
+        update[lane] = x;
+        distance[lane] = d;
+    }
+}
+
+// Helper function
+// Adds a player that was just linked to the team (and counted) to the
+// skip list. Pushes at either end only touch the lanes of the new tower.
+static inline void team_skip_link(team_t* t, player_t* p) {
+
+    team_skiplist_t* sl = t->skip;
+    int old[TEAM_SKIP_LEVELS];
+    int lane;
+
+    p->tower = NULL;
+    team_tower_t* tower = team_skip_new_tower(sl, p, t->activePlayers - 1);
+    int height = tower != NULL ? tower->height : 0;
+    TEAM_STAT_ALLOC(t, tower != NULL);
+
+    if (p == t->head) {
+        for (lane = 0; lane < height; lane++) {
+            old[lane] = team_skip_span(sl, sl->header, lane);
+        }
+        sl->frontShift++;
+        for (lane = 0; lane < height; lane++) {
+            team_skip_link_after(sl, sl->header, tower, lane);
+            team_skip_set_span(sl, tower, lane, old[lane]);
+            team_skip_set_span(sl, sl->header, lane, 1);
+        }
+    }
+    else if (p == t->tail) {
+        for (lane = 0; lane < height; lane++) {
+            old[lane] = team_skip_span(sl, sl->laneTail[lane], lane);
+        }
+        sl->backShift++;
+        for (lane = 0; lane < height; lane++) {
+            team_tower_t* last = sl->laneTail[lane];
+            team_skip_link_after(sl, last, tower, lane);
+            team_skip_set_span(sl, last, lane, old[lane]);
+            team_skip_set_span(sl, tower, lane, 1);
+        }
+    }
+    else {
+        team_tower_t* update[TEAM_SKIP_LEVELS];
+        int distance[TEAM_SKIP_LEVELS];
+        team_skip_path(sl, p, update, distance);
+
+        for (lane = 0; lane < sl->level; lane++) {
+            int span = team_skip_span(sl, update[lane], lane);
+            if (lane < height) {
+                team_skip_link_after(sl, update[lane], tower, lane);
+                team_skip_set_span(sl, update[lane], lane, distance[lane]);
+                team_skip_set_span(sl, tower, lane, span + 1 - distance[lane]);
+            }
+            else {
+                team_skip_set_span(sl, update[lane], lane, span + 1);
+            }
+        }
+    }
+
+    p->tower = tower;
+}
+
+// Helper function
+// Takes a player about to be unlinked from the team (and still counted)
+// out of the skip list. Pops at either end only touch the lanes of its
+// own tower.
+static inline void team_skip_unlink(team_t* t, player_t* p) {
+
+    team_skiplist_t* sl = t->skip;
+    team_tower_t* tower = p->tower;
+    int height = tower != NULL ? tower->height : 0;
+    int old[TEAM_SKIP_LEVELS];
+    int lane;
+
+    if (p == t->head) {
+        for (lane = 0; lane < height; lane++) {
+            old[lane] = team_skip_span(sl, tower, lane);
+            team_skip_unlink_lane(sl, tower, lane);
+        }
+        sl->frontShift--;
+        for (lane = 0; lane < height; lane++) {
+            team_skip_set_span(sl, sl->header, lane, old[lane]);
+        }
+    }
+    else if (p == t->tail) {
+        for (lane = 0; lane < height; lane++) {
+            old[lane] = team_skip_span(sl, tower->lanes[lane].previous, lane);
+            team_skip_unlink_lane(sl, tower, lane);
+        }
+        sl->backShift--;
+        for (lane = 0; lane < height; lane++) {
+            team_skip_set_span(sl, sl->laneTail[lane], lane, old[lane]);
+        }
+    }
+    else {
+        team_tower_t* update[TEAM_SKIP_LEVELS];
+        int distance[TEAM_SKIP_LEVELS];
+        team_skip_path(sl, p, update, distance);
+
+        for (lane = 0; lane < sl->level; lane++) {
+            int span = team_skip_span(sl, update[lane], lane);
+            if (lane < height) {
+                span += team_skip_span(sl, tower, lane);
+                team_skip_unlink_lane(sl, tower, lane);
+            }
+            team_skip_set_span(sl, update[lane], lane, span - 1);
+        }
+    }
+
+    while (sl->level > 0 && sl->header->lanes[sl->level - 1].next == NULL) {
+        sl->level--;
+    }
+
+    free(tower);
+    p->tower = NULL;
+}
+
+// Helper function
+// Returns the player at pos, which must be a valid position, by dropping
+// down the express lanes and walking the last few players of the chain.
+static inline player_t* team_skip_find(team_t* t, int pos) {
+
+    team_skiplist_t* sl = t->skip;
+    team_tower_t* x = sl->header;
+    int at = -1;
+    int lane;
+
+    for (lane = sl->level - 1; lane >= 0; lane--) {
+        while (x->lanes[lane].next != NULL && at + team_skip_span(sl, x, lane) <= pos) {
+            at += team_skip_span(sl, x, lane);
+            x = x->lanes[lane].next;
+            TEAM_STAT_HOPS(t, 1);
+        }
+    }
+
+    player_t* iterator = x->player;
+    if (iterator == NULL) {
+        iterator = t->head;
+        at = 0;
+    }
+    TEAM_STAT_HOPS(t, pos - at);
+    for (; at < pos; at++) {
+        iterator = iterator->next;
+    }
+
+    return iterator;
+}
+
+// Helper function
+// Frees the towers of every player on the team and empties the lanes.
+static inline void team_skip_clear(team_t* t) {
+
+    team_skiplist_t* sl = t->skip;
+    player_t* iterator;
+    for (iterator = t->head; iterator != NULL; iterator = iterator->next) {
+        free(iterator->tower);
+        iterator->tower = NULL;
+    }
+
+    int lane;
+    for (lane = 0; lane < TEAM_SKIP_LEVELS; lane++) {
+        sl->header->lanes[lane].next = NULL;
+    }
+    sl->level = 0;
+    sl->frontShift = 0;
+    sl->backShift = 0;
+}
+
+// Helper function
+// Links the towers the players already have into the lanes again in the
+// current chain order, for when the chain was reordered.
+static inline void team_skip_relink(team_t* t) {
+
+    team_skiplist_t* sl = t->skip;
+    int lastPos[TEAM_SKIP_LEVELS];
+    int lane;
+    for (lane = 0; lane < TEAM_SKIP_LEVELS; lane++) {
+        lastPos[lane] = -1;
+    }
+    for (lane = 0; lane < sl->level; lane++) {
+        sl->header->lanes[lane].next = NULL;
+        sl->laneTail[lane] = sl->header;
+    }
+    sl->frontShift = 0;
+    sl->backShift = 0;
+
+    player_t* iterator;
+    int pos = 0;
+    for (iterator = t->head; iterator != NULL; iterator = iterator->next) {
+        int height = iterator->tower != NULL ? iterator->tower->height : 0;
+        for (lane = 0; lane < height; lane++) {
+            team_tower_t* last = sl->laneTail[lane];
+            team_skip_link_after(sl, last, iterator->tower, lane);
+            team_skip_set_span(sl, last, lane, pos - lastPos[lane]);
+            lastPos[lane] = pos;
+        }
+        pos++;
+    }
+
+    for (lane = 0; lane < sl->level; lane++) {
+        team_skip_set_span(sl, sl->laneTail[lane], lane, pos - lastPos[lane]);
+    }
+}
+
+// Helper function
+// Builds the express lanes again for the current chain, for when players
+// were moved in or out wholesale.
+static inline void team_skip_rebuild(team_t* t) {
+
+    team_skip_clear(t);
+
+    player_t* iterator;
+    int pos = 0;
+    for (iterator = t->head; iterator != NULL; iterator = iterator->next) {
+        iterator->tower = team_skip_new_tower(t->skip, iterator, pos);
+        pos++;
+    }
+
+    team_skip_relink(t);
+}
+
+// Helper function
+// Bookkeeping for a player that was just linked into the team.
+// The cursor survives pushes at either end, a player linked in the middle
+// drops it since its position is not known here.
+static inline void team_track_link(team_t* t, player_t* p) {
+
+    if (t->index != NULL) {
+        team_index_place(t->index, p);
+        t->index->used++;
+    }
+
+    if (t->skip != NULL) {
+        team_skip_link(t, p);
+    }
+
+    if (t->cursor != NULL) {
+        if (p == t->head) {
+            t->cursorPos++;
+        }
+        else if (p != t->tail) {
+            t->cursor = NULL;
+        }
+    }
+}
+
+// Helper function
+// Bookkeeping for a player about to be unlinked from the team.
+// A cursor on p moves to the player taking its position.
+static inline void team_track_unlink(team_t* t, player_t* p) {
+
+    if (t->index != NULL) {
+        team_index_drop(t->index, p);
+    }
+
+    if (t->skip != NULL) {
+        team_skip_unlink(t, p);
+    }
+
+    if (t->cursor == p) {
+        if (p->next != NULL) {
+            t->cursor = p->next;
+        }
+        else {
+            t->cursor = p->previous;
+            t->cursorPos--;
+        }
+    }
+    else if (t->cursor != NULL) {
+        if (p == t->head) {
+            t->cursorPos--;
+        }
+        else if (p != t->tail) {
+            t->cursor = NULL;
+        }
+    }
+}
+
+// Helper function
+// Returns the player at pos, which must be a valid position, walking from
+// whichever of the head, the tail and the cursor is closest, or dropping
+// down the skip list when it has one and that is not a short walk. The
+// cursor is left on the returned player so sequential access is O(1) per
+// step.
+static inline player_t* team_walk(team_t* t, int pos) {
+
+    player_t* iterator = t->head;
+    int at = 0;
+    int distance = pos;
+
+    if (t->activePlayers - 1 - pos < distance) {
+        iterator = t->tail;
+        at = t->activePlayers - 1;
+        distance = at - pos;
+    }
+
+    if (t->cursor != NULL && abs(t->cursorPos - pos) < distance) {
+        iterator = t->cursor;
+        at = t->cursorPos;
+        distance = abs(at - pos);
+    }
+
+    if (t->skip != NULL && distance > 8) {
+        iterator = team_skip_find(t, pos);
+        at = pos;
+    }
+
+    TEAM_STAT_HOPS(t, abs(at - pos));
+    for (; at < pos; at++) {
+        iterator = iterator->next;
+    }
+    for (; at > pos; at--) {
+        iterator = iterator->previous;
+    }
+
+    t->cursor = iterator;
+    t->cursorPos = pos;
+
+    return iterator;
+}
+
+// Helper function
+// Returns 1 if a player numbered rosterNum comes before where roster goes
+// on a sorted team: below it, or also equal to it when after is set.
+static inline int team_sorted_passes(int rosterNum, int roster, int after) {
+
+    return rosterNum < roster || (after && rosterNum == roster);
+}
+
+// Helper function
+// Finds where roster goes on a sorted team by running along each express
+// lane while the next tower still comes before it, then walking the few
+// players left on the chain. That is the first player not below roster,
+// or with after set the first one above it, so equal numbers are placed
+// in the order they came. Sets *pos to its position and leaves the
+// cursor there.
+// Returns the player, or NULL if every player comes before roster.
+static inline player_t* team_sorted_seek(team_t* t, int roster, int after, int* pos) {
+
+    team_skiplist_t* sl = t->skip;
+    team_tower_t* x = sl->header;
+    int at = -1;
+    int lane;
+
+    for (lane = sl->level - 1; lane >= 0; lane--) {
+        while (x->lanes[lane].next != NULL &&
+               team_sorted_passes(x->lanes[lane].next->player->rosterNum, roster, after)) {
+            at += team_skip_span(sl, x, lane);
+            x = x->lanes[lane].next;
+            TEAM_STAT_HOPS(t, 1);
+        }
+    }
+
+    player_t* iterator = x->player != NULL ? x->player->next : t->head;
+    at++;
+    while (iterator != NULL && team_sorted_passes(iterator->rosterNum, roster, after)) {
+        iterator = iterator->next;
+        at++;
+        TEAM_STAT_HOPS(t, 1);
+    }
+
+    if (iterator != NULL) {
+        t->cursor = iterator;
+        t->cursorPos = at;
+    }
+    *pos = at;
+
+    return iterator;
+}
+
+// Helper function
+// Returns 1 if players numbered low up to high can go before position pos
+// of a sorted team without breaking its order.
+static inline int team_sorted_fits(team_t* t, int pos, int low, int high) {
+
+    player_t* after = pos < t->activePlayers ? team_walk(t, pos) : NULL;
+    player_t* before = after != NULL ? after->previous : t->tail;
+
+    return (before == NULL || before->rosterNum <= low) &&
+           (after == NULL || high <= after->rosterNum);
+}
+
+// Creates a player that is on no team, with a copy of name.
+// Returns a pointer to the new player, release it with free_player.
+// Returns NULL if we could not allocate memory.
+static inline player_t* create_player(int roster, char* name){
+
+    int nameSize = strlen(name);
+    player_t* newPlayer = (player_t*)malloc(sizeof(player_t));
+    if (newPlayer == NULL) {
+        return NULL;
+    }
+
+    newPlayer->flags = 0;
+    if (nameSize < PLAYER_INLINE_NAME) {
+        newPlayer->name = newPlayer->inlineName;
+    }
+    else {
+        newPlayer->name = (char*)malloc(sizeof(char) * (nameSize + 1));
+        if (newPlayer->name == NULL) {
+            free(newPlayer);
+            return NULL;
+        }
+    }
+
+    newPlayer->rosterNum = roster;
+    newPlayer->next = NULL;
+    newPlayer->previous = NULL;
+    newPlayer->tower = NULL;
+    memcpy(newPlayer->name, name, nameSize + 1);
+
+    return newPlayer;
+}
+
+// Helper function
+// Returns the bytes a spare player's own name buffer holds, which
+// team_recycle_player stored in its unused inline name.
+static inline size_t team_spare_capacity(player_t* p) {
+
+    size_t capacity;
+    memcpy(&capacity, p->inlineName, sizeof(capacity));
+    return capacity;
+}
+
+// Helper function
+// Lets go of the name buffer of a spare player, which then uses its
+// inline name again.
+static inline void team_spare_drop_name(player_t* p) {
+
+    if (p->name != p->inlineName && !(p->flags & PLAYER_NAME_ARENA)) {
+        free(p->name);
+    }
+    p->name = p->inlineName;
+    p->flags &= ~PLAYER_NAME_ARENA;
+}
+
+// Helper function
+// Takes the first spare player of the team for a new player, when its
+// name can be stored without allocating: in the name buffer the spare
+// player kept if that is big enough, inline if it is short, or shared
+// from the team's intern table.
+// Returns NULL if name needs a new allocation, the spare player is left
+// for the next push.
+static inline player_t* team_spare_player(team_t* t, int roster, char* name) {
+
+    player_t* p = t->spare;
+    size_t nameSize = strlen(name);
+
+    if (t->names != NULL) {
+        char* interned = team_names_intern(t->names, name);
+        if (interned == NULL) {
+            return NULL;
+        }
+        team_spare_drop_name(p);
+        p->name = interned;
+        p->flags |= PLAYER_NAME_INTERNED;
+    }
+    else if (p->name != p->inlineName && team_spare_capacity(p) > nameSize) {
+        memcpy(p->name, name, nameSize + 1);
+    }
+    else if (nameSize < PLAYER_INLINE_NAME) {
+        team_spare_drop_name(p);
+        memcpy(p->name, name, nameSize + 1);
+    }
+    else {
+        return NULL;
+    }
+
+    t->spare = p->next;
+    t->spareCount--;
+    p->rosterNum = roster;
+    p->next = NULL;
+    p->previous = NULL;
+    p->tower = NULL;
+    TEAM_STAT_PLAYERS(t, 1);
+
+    return p;
+}
+
+// Helper function
+// Allocates a new unlinked player with a copy of name, from the team pool
+// if the team has one. Short names are kept inline, longer ones go to the
+// pool name arena or get their own allocation, and on a team using an
+// intern table every name is shared from there. A player kept by
+// team_recycle_player is reused first when it saves the allocations.
+// Also reserves the index slot the player will take once linked.
+// Returns NULL if we could not allocate memory.
+static inline player_t* team_new_player(team_t* t, int roster, char* name) {
+
+#ifdef TEAM_STATS
+    player_t** indexSlots = t->index != NULL ? t->index->slots : NULL;
+#endif
+    if (t->index != NULL && !team_index_reserve(t->index, 1)) {
+        return NULL;
+    }
+    TEAM_STAT_ALLOC(t, t->index != NULL && t->index->slots != indexSlots);
+
+    if (t->spare != NULL) {
+        player_t* reused = team_spare_player(t, roster, name);
+        if (reused != NULL) {
+            return reused;
+        }
+    }
+
+    if (t->names != NULL) {
+#ifdef TEAM_STATS
+        int namesHeld = t->names->count;
+#endif
+        player_t* newPlayer = t->pool != NULL ? team_pool_player(t->pool) : (player_t*)malloc(sizeof(player_t));
+        if (newPlayer == NULL) {
+            return NULL;
+        }
+        newPlayer->flags = t->pool != NULL ? PLAYER_NODE_POOL : 0;
+        newPlayer->name = team_names_intern(t->names, name);
+        if (newPlayer->name == NULL) {
+            free_player(newPlayer);
+            return NULL;
+        }
+        newPlayer->flags |= PLAYER_NAME_INTERNED;
+        newPlayer->rosterNum = roster;
+        newPlayer->next = NULL;
+        newPlayer->previous = NULL;
+        newPlayer->tower = NULL;
+        TEAM_STAT_PLAYERS(t, 1);
+        TEAM_STAT_ALLOC(t, (t->pool == NULL) + (t->names->count != namesHeld));
+        return newPlayer;
+    }
+
+    if (t->pool == NULL) {
+        player_t* created = create_player(roster, name);
+        if (created != NULL) {
+            TEAM_STAT_PLAYERS(t, 1);
+            TEAM_STAT_ALLOC(t, created->name == created->inlineName ? 1 : 2);
+        }
+        return created;
+    }
+
+#ifdef TEAM_STATS
+    team_slab_t* slabs = t->pool->slabs;
+    team_arena_chunk_t* arena = t->pool->names;
+#endif
+    int nameSize = strlen(name);
+    player_t* newPlayer = team_pool_player(t->pool);
+    if (newPlayer == NULL) {
+        return NULL;
+    }
+    newPlayer->flags = PLAYER_NODE_POOL;
+
+    if (nameSize < PLAYER_INLINE_NAME) {
+        newPlayer->name = newPlayer->inlineName;
+    }
+    else {
+        newPlayer->name = team_pool_bytes(t->pool, nameSize + 1);
+        newPlayer->flags |= PLAYER_NAME_ARENA;
+    }
+
+    if (newPlayer->name == NULL) {
+        newPlayer->flags &= ~PLAYER_NAME_ARENA;
+        free_player(newPlayer);
+        return NULL;
+    }
+
+    newPlayer->rosterNum = roster;
+    newPlayer->tower = NULL;
+    memcpy(newPlayer->name, name, nameSize + 1);
+    TEAM_STAT_PLAYERS(t, 1);
+    TEAM_STAT_ALLOC(t, (t->pool->slabs != slabs) + (t->pool->names != arena));
+
+    return newPlayer;
+}
+
+
+
+// Helper function
+// Returns the chunk holding position pos of an unrolled team and sets
+// *offset to its index there. pos may be the team size, which lands past
+// the last player of the last chunk. Walks from the nearest of either end
+// and the chunk cursor, then leaves the cursor on the chunk found.
+static inline team_chunk_t* team_chunk_at(team_t* t, int pos, int* offset) {
+
+    team_chunk_t* chunk;
+    int start;
+
+    if (t->cursorChunk != NULL &&
+        abs(t->cursorChunkPos - pos) < pos &&
+        abs(t->cursorChunkPos - pos) < t->activePlayers - pos) {
+        chunk = t->cursorChunk;
+        start = t->cursorChunkPos;
+    }
+    else if (pos <= t->activePlayers / 2) {
+        chunk = t->firstChunk;
+        start = 0;
+    }
+    else {
+        chunk = t->lastChunk;
+        start = t->activePlayers - chunk->count;
+    }
+
+    while (pos < start) {
+        chunk = chunk->previous;
+        start -= chunk->count;
+        TEAM_STAT_HOPS(t, 1);
+    }
+    while (pos >= start + chunk->count && chunk->next != NULL) {
+        start += chunk->count;
+        chunk = chunk->next;
+        TEAM_STAT_HOPS(t, 1);
+    }
+
+    t->cursorChunk = chunk;
+    t->cursorChunkPos = start;
+    *offset = pos - start;
+
+    return chunk;
+}
+
+// Helper function
+// Allocates an empty chunk and links it after previous, or first if
+// previous is NULL.
+// Returns NULL if we could not allocate memory.
+static inline team_chunk_t* team_chunk_new(team_t* t, team_chunk_t* previous) {
+
+    team_chunk_t* chunk = (team_chunk_t*)malloc(sizeof(team_chunk_t));
+    if (chunk == NULL) {
+        return NULL;
+    }
+    TEAM_STAT_ALLOC(t, 1);
+    chunk->count = 0;
+    chunk->previous = previous;
+    chunk->next = previous != NULL ? previous->next : t->firstChunk;
+
+    if (chunk->next != NULL) {
+        chunk->next->previous = chunk;
+    }
+    else {
+        t->lastChunk = chunk;
+    }
+    if (previous != NULL) {
+        previous->next = chunk;
+    }
+    else {
+        t->firstChunk = chunk;
+    }
+
+    return chunk;
+}
+
+// Helper function
+// Unlinks an empty chunk and frees it.
+static inline void team_chunk_free(team_t* t, team_chunk_t* chunk) {
+
+    if (chunk->previous != NULL) {
+        chunk->previous->next = chunk->next;
+    }
+    else {
+        t->firstChunk = chunk->next;
+    }
+    if (chunk->next != NULL) {
+        chunk->next->previous = chunk->previous;
+    }
+    else {
+        t->lastChunk = chunk->previous;
+    }
+
+    free(chunk);
+}
+
+// Helper function
+// Inserts a player at pos of an unrolled team. A full chunk at either
+// end gets a fresh neighbour so pushes keep chunks packed, a full chunk
+// in the middle is split in half.
+// Returns 1 on success
+// Returns 0 if we could not allocate memory.
+static inline int team_chunk_insert(team_t* t, int pos, int roster, char* name) {
+
+    int nameSize = strlen(name);
+    char* copy = (char*)malloc(sizeof(char) * (nameSize + 1));
+    if (copy == NULL) {
+        return 0;
+    }
+    memcpy(copy, name, nameSize + 1);
+    TEAM_STAT_PLAYERS(t, 1);
+    TEAM_STAT_ALLOC(t, 1);
+
+    team_chunk_t* chunk;
+    int offset = 0;
+
+    if (t->firstChunk == NULL) {
+        chunk = team_chunk_new(t, NULL);
+    }
+    else {
+        chunk = team_chunk_at(t, pos, &offset);
+        if (chunk->count == TEAM_CHUNK_PLAYERS) {
+            if (pos == 0) {
+                chunk = team_chunk_new(t, NULL);
+            }
+            else if (pos == t->activePlayers) {
+                chunk = team_chunk_new(t, chunk);
+                offset = 0;
+            }
+            else {
+                team_chunk_t* half = team_chunk_new(t, chunk);
+                if (half != NULL) {
+                    int keep = TEAM_CHUNK_PLAYERS / 2;
+                    half->count = TEAM_CHUNK_PLAYERS - keep;
+                    memcpy(half->rosterNums, chunk->rosterNums + keep, sizeof(int) * half->count);
+                    memcpy(half->names, chunk->names + keep, sizeof(char*) * half->count);
+                    chunk->count = keep;
+                    if (offset > keep) {
+                        chunk = half;
+                        offset -= keep;
+                    }
+                }
+                else {
+                    chunk = NULL;
+                }
+            }
+        }
+    }
+
+    t->cursorChunk = NULL;
+    if (chunk == NULL) {
+        free(copy);
+        return 0;
+    }
+
+    memmove(chunk->rosterNums + offset + 1, chunk->rosterNums + offset, sizeof(int) * (chunk->count - offset));
+    memmove(chunk->names + offset + 1, chunk->names + offset, sizeof(char*) * (chunk->count - offset));
+    chunk->rosterNums[offset] = roster;
+    chunk->names[offset] = copy;
+    chunk->count++;
+    t->activePlayers++;
+
+    return 1;
+}
+
+// Helper function
+// Removes the player at pos of an unrolled team, handing its name over to
+// a new player_t. A chunk that runs below half full takes in its next
+// neighbour if they fit together, an empty chunk is freed.
+// Returns NULL if we could not allocate memory.
+static inline player_t* team_chunk_remove(team_t* t, int pos) {
+
+    player_t* removed = (player_t*)malloc(sizeof(player_t));
+    if (removed == NULL) {
+        return NULL;
+    }
+
+    int offset;
+    team_chunk_t* chunk = team_chunk_at(t, pos, &offset);
+    t->cursorChunk = NULL;
+
+    removed->rosterNum = chunk->rosterNums[offset];
+    removed->flags = 0;
+    removed->name = chunk->names[offset];
+    removed->next = NULL;
+    removed->previous = NULL;
+    removed->tower = NULL;
+
+    chunk->count--;
+    memmove(chunk->rosterNums + offset, chunk->rosterNums + offset + 1, sizeof(int) * (chunk->count - offset));
+    memmove(chunk->names + offset, chunk->names + offset + 1, sizeof(char*) * (chunk->count - offset));
+    t->activePlayers--;
+
+    team_chunk_t* next = chunk->next;
+    if (chunk->count == 0) {
+        team_chunk_free(t, chunk);
+    }
+    else if (chunk->count < TEAM_CHUNK_PLAYERS / 2 && next != NULL &&
+             chunk->count + next->count <= TEAM_CHUNK_PLAYERS) {
+        memcpy(chunk->rosterNums + chunk->count, next->rosterNums, sizeof(int) * next->count);
+        memcpy(chunk->names + chunk->count, next->names, sizeof(char*) * next->count);
+        chunk->count += next->count;
+        team_chunk_free(t, next);
+    }
+
+    return removed;
+}
+
+// Helper function
+// Returns the position of the first player of an unrolled team with
+// that roster number.
+// Returns -1 if there is none.
+static inline int team_chunk_find(team_t* t, int roster) {
+
+    team_chunk_t* chunk;
+    int start = 0;
+    for (chunk = t->firstChunk; chunk != NULL; chunk = chunk->next) {
+        TEAM_STAT_HOPS(t, 1);
+        int i;
+        for (i = 0; i < chunk->count; i++) {
+            if (chunk->rosterNums[i] == roster) {
+                return start + i;
+            }
+        }
+        start += chunk->count;
+    }
+
+    return -1;
+}
+
+// Helper function
+// Doubles the arrays of a compact team and chains the new slots up as
+// unused.
+// Returns 1 on success
+// Returns 0 if we could not allocate memory.
+static inline int team_slots_grow(team_slots_t* slots) {
+
+    uint32_t capacity = slots->capacity < 16 ? 16 : slots->capacity * 2;
+    if (capacity <= slots->capacity || capacity == TEAM_NO_SLOT) {
+        return 0;
+    }
+
+    // each array is kept as soon as it has grown, so a failure part way
+    // leaves some arrays larger than capacity but never smaller
+    uint32_t* next = (uint32_t*)realloc(slots->next, sizeof(uint32_t) * capacity);
+    if (next == NULL) {
+        return 0;
+    }
+    slots->next = next;
+    uint32_t* previous = (uint32_t*)realloc(slots->previous, sizeof(uint32_t) * capacity);
+    if (previous == NULL) {
+        return 0;
+    }
+    slots->previous = previous;
+    int* rosterNums = (int*)realloc(slots->rosterNums, sizeof(int) * capacity);
+    if (rosterNums == NULL) {
+        return 0;
+    }
+    slots->rosterNums = rosterNums;
+    char** names = (char**)realloc(slots->names, sizeof(char*) * capacity);
+    if (names == NULL) {
+        return 0;
+    }
+    slots->names = names;
+
+    uint32_t i;
+    for (i = capacity; i > slots->capacity; i--) {
+        slots->next[i - 1] = slots->freeSlot;
+        slots->freeSlot = i - 1;
+    }
+    slots->capacity = capacity;
+
+    return 1;
+}
+
+// Helper function
+// Returns the slot at pos of a compact team, pos must be a valid position.
+// Walks from the nearest of either end and the cursor, then leaves the
+// cursor there.
+static inline uint32_t team_slots_at(team_t* t, int pos) {
+
+    team_slots_t* slots = t->slots;
+    uint32_t slot = slots->head;
+    int at = 0;
+    int distance = pos;
+
+    if (t->activePlayers - 1 - pos < distance) {
+        slot = slots->tail;
+        at = t->activePlayers - 1;
+        distance = at - pos;
+    }
+    if (slots->cursor != TEAM_NO_SLOT && abs(t->cursorPos - pos) < distance) {
+        slot = slots->cursor;
+        at = t->cursorPos;
+    }
+
+    TEAM_STAT_HOPS(t, abs(at - pos));
+    for (; at < pos; at++) {
+        slot = slots->next[slot];
+    }
+    for (; at > pos; at--) {
+        slot = slots->previous[slot];
+    }
+
+    slots->cursor = slot;
+    t->cursorPos = pos;
+
+    return slot;
+}
+
+// Helper function
+// Inserts a player at pos of a compact team.
+// Returns 1 on success
+// Returns 0 if we could not allocate memory.
+static inline int team_slots_insert(team_t* t, int pos, int roster, char* name) {
+
+    team_slots_t* slots = t->slots;
+    if (slots->freeSlot == TEAM_NO_SLOT) {
+        if (!team_slots_grow(slots)) {
+            return 0;
+        }
+        TEAM_STAT_ALLOC(t, 4);
+    }
+
+    int nameSize = strlen(name);
+    char* copy = (char*)malloc(sizeof(char) * (nameSize + 1));
+    if (copy == NULL) {
+        return 0;
+    }
+    memcpy(copy, name, nameSize + 1);
+    TEAM_STAT_PLAYERS(t, 1);
+    TEAM_STAT_ALLOC(t, 1);
+
+    uint32_t before = pos < t->activePlayers ? team_slots_at(t, pos) : TEAM_NO_SLOT;
+    uint32_t after = before != TEAM_NO_SLOT ? slots->previous[before] : slots->tail;
+
+    uint32_t slot = slots->freeSlot;
+    slots->freeSlot = slots->next[slot];
+    slots->rosterNums[slot] = roster;
+    slots->names[slot] = copy;
+    slots->next[slot] = before;
+    slots->previous[slot] = after;
+
+    if (before != TEAM_NO_SLOT) {
+        slots->previous[before] = slot;
+    }
+    else {
+        slots->tail = slot;
+    }
+    if (after != TEAM_NO_SLOT) {
+        slots->next[after] = slot;
+    }
+    else {
+        slots->head = slot;
+    }
+
+    slots->cursor = TEAM_NO_SLOT;
+    t->activePlayers++;
+
+    return 1;
+}
+
+// Helper function
+// Removes the player at pos of a compact team, handing its name over to
+// a new player_t.
+// Returns NULL if we could not allocate memory.
+static inline player_t* team_slots_remove(team_t* t, int pos) {
+
+    player_t* removed = (player_t*)malloc(sizeof(player_t));
+    if (removed == NULL) {
+        return NULL;
+    }
+
+    team_slots_t* slots = t->slots;
+    uint32_t slot = team_slots_at(t, pos);
+    uint32_t next = slots->next[slot];
+    uint32_t previous = slots->previous[slot];
+
+    removed->rosterNum = slots->rosterNums[slot];
+    removed->flags = 0;
+    removed->name = slots->names[slot];
+    removed->next = NULL;
+    removed->previous = NULL;
+    removed->tower = NULL;
+
+    if (next != TEAM_NO_SLOT) {
+        slots->previous[next] = previous;
+    }
+    else {
+        slots->tail = previous;
+    }
+    if (previous != TEAM_NO_SLOT) {
+        slots->next[previous] = next;
+    }
+    else {
+        slots->head = next;
+    }
+
+    slots->next[slot] = slots->freeSlot;
+    slots->freeSlot = slot;
+    slots->cursor = TEAM_NO_SLOT;
+    t->activePlayers--;
+
+    return removed;
+}
+
+// Helper function
+// Returns the position of the first player of a compact team with that
+// roster number.
+// Returns -1 if there is none.
+static inline int team_slots_find(team_t* t, int roster) {
+
+    team_slots_t* slots = t->slots;
+    uint32_t slot;
+    int pos = 0;
+    for (slot = slots->head; slot != TEAM_NO_SLOT; slot = slots->next[slot]) {
+        TEAM_STAT_HOPS(t, 1);
+        if (slots->rosterNums[slot] == roster) {
+            return pos;
+        }
+        pos++;
+    }
+
+    return -1;
+}
+
+// Helper function
+// Inserts a player at pos of a team that does not use player_t nodes.
+// Returns 1 on success
+// Returns 0 if we could not allocate memory.
+static inline int team_store_insert(team_t* t, int pos, int roster, char* name) {
+
+    if (t->storage == TEAM_STORAGE_UNROLLED) {
+        return team_chunk_insert(t, pos, roster, name);
+    }
+    return team_slots_insert(t, pos, roster, name);
+}
+
+// Helper function
+// Removes the player at pos of a team that does not use player_t nodes,
+// as a new player_t.
+// Returns NULL if we could not allocate memory.
+static inline player_t* team_store_remove(team_t* t, int pos) {
+
+    if (t->storage == TEAM_STORAGE_UNROLLED) {
+        return team_chunk_remove(t, pos);
+    }
+    return team_slots_remove(t, pos);
+}
+
+// Helper function
+// Returns the roster number at pos of a team that does not use player_t
+// nodes, pos must be a valid position.
+static inline int team_store_get(team_t* t, int pos) {
+
+    if (t->storage == TEAM_STORAGE_UNROLLED) {
+        int offset;
+        team_chunk_t* chunk = team_chunk_at(t, pos, &offset);
+        return chunk->rosterNums[offset];
+    }
+    return t->slots->rosterNums[team_slots_at(t, pos)];
+}
+
+// Helper function
+// Returns the position of the first player with that roster number on a
+// team that does not use player_t nodes.
+// Returns -1 if there is none.
+static inline int team_store_find(team_t* t, int roster) {
+
+    if (t->storage == TEAM_STORAGE_UNROLLED) {
+        return team_chunk_find(t, roster);
+    }
+    return team_slots_find(t, roster);
+}
+
+// Helper function
+// Builds count players from rosters and names as one chain in a single
+// bulk block: slabs of players followed by the names too long to keep
+// inline. With blob set, names is not used and the players point at
+// count names packed one after another in blob instead, which must stay
+// put as long as the block, see team_slab_t.mapping. On a pooled team the
+// block joins the pool, otherwise it keeps a count of its live players
+// and goes away with the last of them.
+// Sets *first and *last to the ends of the chain.
+// Returns 1 on success
+// Returns 0 if we could not allocate memory.
+static inline int team_bulk_chain(team_t* t, int count, int* rosters, char** names, char* blob, player_t** first, player_t** last) {
+
+    size_t header = (sizeof(team_slab_t) + TEAM_ALIGNOF(player_t) - 1) & ~(TEAM_ALIGNOF(player_t) - 1);
+    size_t perSlab = (TEAM_SLAB_BYTES - header) / sizeof(player_t);
+    size_t slabs = (count + perSlab - 1) / perSlab;
+    size_t nameBytes = 0;
+    int i;
+
+    for (i = 0; blob == NULL && i < count; i++) {
+        size_t nameSize = strlen(names[i]);
+        if (nameSize >= PLAYER_INLINE_NAME) {
+            nameBytes += nameSize + 1;
+        }
+    }
+
+    size_t size = slabs * TEAM_SLAB_BYTES + nameBytes;
+    size = (size + TEAM_SLAB_BYTES - 1) & ~(size_t)(TEAM_SLAB_BYTES - 1);
+    team_slab_t* block = (team_slab_t*)aligned_alloc(TEAM_SLAB_BYTES, size);
+    if (block == NULL) {
+        return 0;
+    }
+    TEAM_STAT_PLAYERS(t, count);
+    TEAM_STAT_ALLOC(t, 1);
+
+    size_t k;
+    for (k = 0; k < slabs; k++) {
+        team_slab_t* slab = (team_slab_t*)((char*)block + k * TEAM_SLAB_BYTES);
+        slab->pool = t->pool;
+        slab->owner = block;
+    }
+    __atomic_store_n(&block->live, count, __ATOMIC_RELEASE);
+    block->mapping = NULL;
+    if (t->pool != NULL) {
+        block->nextSlab = t->pool->slabs;
+        t->pool->slabs = block;
+    }
+
+    char* nameBump = (char*)block + slabs * TEAM_SLAB_BYTES;
+    unsigned char flags = t->pool != NULL ? PLAYER_NODE_POOL : PLAYER_NODE_BLOCK;
+    player_t* previous = NULL;
+
+    for (i = 0; i < count; i++) {
+        player_t* p = (player_t*)((char*)block + (i / perSlab) * TEAM_SLAB_BYTES + header + (i % perSlab) * sizeof(player_t));
+
+        p->rosterNum = rosters[i];
+        p->flags = flags;
+        p->tower = NULL;
+        if (blob != NULL) {
+            p->name = blob;
+            p->flags |= PLAYER_NAME_ARENA;
+            blob += strlen(blob) + 1;
+        }
+        else {
+            size_t nameSize = strlen(names[i]);
+            if (nameSize < PLAYER_INLINE_NAME) {
+                p->name = p->inlineName;
+            }
+            else {
+                p->name = nameBump;
+                p->flags |= PLAYER_NAME_ARENA;
+                nameBump += nameSize + 1;
+            }
+            memcpy(p->name, names[i], nameSize + 1);
+        }
+
+        p->previous = previous;
+        if (previous != NULL) {
+            previous->next = p;
+        }
+        else {
+            *first = p;
+        }
+        previous = p;
+    }
+    previous->next = NULL;
+    *last = previous;
+
+    return 1;
+}
+
+// Check if the team is empty
+// Returns -1 if the team is NULL.
+// Returns 1 if true (The team is completely empty)
+// Returns 0 if false (the team DLL has at least one player enqueued)
+static inline int team_empty(team_t* t){
+
+    if (t == NULL) {
+        return -1;
+    }
+    else if (t->activePlayers == 0) {
+        return 1;
+    }
+    else if (t->activePlayers > 0){
+        return 0;
+    }
+
+    return -1; 
+}
+
+// push a new player to the front of the DLL ( before the first player in the list).
+// Returns -1 if DLL is NULL.
+// Returns 1 on success
+// Returns 0 on failure, also when it would break the order of a sorted team.
+static inline int team_push_front(team_t* t, int roster, char* name){
+
+    TEAM_STAT_OP(t, TEAM_OP_PUSH_FRONT);
+    if (t == NULL) {
+        return -1;
+    }
+
+    if (t->storage != TEAM_STORAGE_LINKED) {
+        return team_store_insert(t, 0, roster, name);
+    }
+
+    if (t->sorted && t->head != NULL && t->head->rosterNum < roster) {
+        return 0;
+    }
+
+    player_t* newPlayer = team_new_player(t, roster, name);
+    if (newPlayer == NULL) {
+        return 0;
+    }
+
+    newPlayer->next = t->head;
+    newPlayer->previous = NULL;
+
+    if (t->head != NULL) {
+        t->head->previous = newPlayer;
+    }
+    
+    t->head = newPlayer;
+    if (t->activePlayers == 0) {
+        t->tail = newPlayer;
+    }
+
+    t->activePlayers++;
+    team_track_link(t, newPlayer);
+   
+    return 1;
+}
+
+// push a new player to the end of the team DLL (after the last player in the list).
+// Returns -1 if DLL is NULL.
+// Returns 1 on success
+// Returns 0 on failure, also when it would break the order of a sorted team.
+static inline int team_push_back(team_t* t, int roster, char* name){
+	
+    TEAM_STAT_OP(t, TEAM_OP_PUSH_BACK);
+    if (t == NULL) {
+        return -1;
+    }
+
+    if (t->storage != TEAM_STORAGE_LINKED) {
+        return team_store_insert(t, t->activePlayers, roster, name);
+    }
+
+    if (t->sorted && t->tail != NULL && roster < t->tail->rosterNum) {
+        return 0;
+    }
+
+    player_t* newPlayer = team_new_player(t, roster, name);
+    if (newPlayer == NULL) {
+        return 0;
+    }
+
+    newPlayer->next = NULL;
+    newPlayer->previous = t->tail;
+
+    if (t->tail != NULL) {
+        t->tail->next = newPlayer;
+    }
+
+    t->tail = newPlayer;
+    if (t->activePlayers == 0) {
+        t->head = newPlayer;
+    }
+
+    t->activePlayers++;
+    team_track_link(t, newPlayer);
+
+    return 1;
+}
+
+// Returns the first player in the DLL and also removes it from the team.
+// Returns NULL if the Team is NULL. 
+// Returns NULL on failure, i.e. there is no one to pop from the team.
+static inline player_t* team_pop_front(team_t* t){
+    
+    TEAM_STAT_OP(t, TEAM_OP_POP_FRONT);
+    if (t == NULL) {
+        return NULL;
+    }
+
+    if (t->activePlayers == 0) {
+        return NULL;
+    }
+
+    if (t->storage != TEAM_STORAGE_LINKED) {
+        return team_store_remove(t, 0);
+    }
+
+    player_t* temp;
+    temp = t->head;
+    team_track_unlink(t, temp);
+    t->head = t->head->next;
+
+    if (t->activePlayers == 1) {
+        t->tail = NULL;
+    }
+    else {
+        t->head->previous = NULL;
+    }
+	
+    t->activePlayers--;
+
+    return temp;
+}
+
+// Returns the last player in the Team, and also removes it from the list.
+// Returns NULL if the Team is NULL. 
+// Returns NULL on failure.
+static inline player_t* team_pop_back(team_t* t){
+    
+    TEAM_STAT_OP(t, TEAM_OP_POP_BACK);
+    if (t == NULL) {
+        return NULL;
+    }
+	
+    if (t->activePlayers == 0) {
+        return NULL;
+    }
+
+    if (t->storage != TEAM_STORAGE_LINKED) {
+        return team_store_remove(t, t->activePlayers - 1);
+    }
+
+    player_t* temp;
+    temp = t->tail;
+    team_track_unlink(t, temp);
+    t->tail = t->tail->previous;
+      
+    if (t->activePlayers == 1) {
+        t->head = NULL;
+    }
+    else {
+        t->tail->next = NULL;
+    }
+
+    t->activePlayers--;
+    
+    return temp;
+}
+
+// Inserts a new player before the player at the specified position.
+// On a sorted team the player must fit there, see team_insert_sorted.
+// Returns -1 if the list is NULL
+// Returns 1 on success
+// Retruns 0 on failure:
+static inline int team_insert(team_t* t, int pos, int roster, char* name){
+    
+    TEAM_STAT_OP(t, TEAM_OP_INSERT);
+    if (t == NULL) {
+        return -1;
+    }
+
+    if (pos < 0 || t->activePlayers < pos) {
+        return 0;
+    }
+
+    if (t->storage != TEAM_STORAGE_LINKED) {
+        return team_store_insert(t, pos, roster, name);
+    }
+
+    if (t->sorted && !team_sorted_fits(t, pos, roster, roster)) {
+        return 0;
+    }
+
+    if (pos == t->activePlayers) {
+        return team_push_back(t, roster, name);
+    }
+
+    player_t* newPlayer = team_new_player(t, roster, name);
+    if (newPlayer == NULL) {
+        return 0;
+    }
+
+    player_t* iterator = NULL;
+    if (t->activePlayers > 0) {
+        iterator = team_walk(t, pos);
+    }
+
+    newPlayer->next = iterator;
+    if (t->activePlayers == 0) {
+        newPlayer->previous = NULL;
+        t->tail = newPlayer;
+    }
+    else {
+        newPlayer->previous = iterator->previous;
+        if (iterator->previous != NULL) {
+            iterator->previous->next = newPlayer;
+        }
+        iterator->previous = newPlayer;
+    }
+
+    if (pos == 0) {
+        t->head = newPlayer;
+    }
+
+    t->activePlayers++;
+    team_track_link(t, newPlayer);
+    t->cursor = newPlayer;
+    t->cursorPos = pos;
+        
+    return 1;
+}
+
+// Returns the roster number of the player at position pos starting at 0 
+// Returns -1 if the list is NULL
+// Returns 0 on failure:
+static inline int team_list_get(team_t* t, int pos){
+    
+    TEAM_STAT_OP(t, TEAM_OP_LIST_GET);
+    if (t == NULL) {
+        return -1;
+    }
+
+    if (pos < 0 || t->activePlayers - 1 < pos) {
+        return 0;
+    }
+
+    if (t->storage != TEAM_STORAGE_LINKED) {
+        return team_store_get(t, pos);
+    }
+
+    return team_walk(t, pos)->rosterNum;
+}
+
+// Removes the player at position pos starting at 0
+// Returns NULL if the list is NULL
+// Returns NULL on failure:
+static inline player_t* team_list_remove(team_t* t, int pos){
+    
+    TEAM_STAT_OP(t, TEAM_OP_LIST_REMOVE);
+    if (t == NULL) {
+        return NULL;
+    }
+
+    if (pos < 0 || t->activePlayers - 1 < pos) {
+        return NULL;
+    }
+
+    if (t->storage != TEAM_STORAGE_LINKED) {
+        return team_store_remove(t, pos);
+    }
+
+    player_t* iterator = team_walk(t, pos);
+
+    if (iterator == NULL) {
+        return NULL;
+    }
+
+    team_track_unlink(t, iterator);
+    if (iterator->previous != NULL) {
+        iterator->previous->next = iterator->next;
+    }
+    else {
+        t->head = iterator->next;
+    }
+
+    if (iterator->next != NULL) {
+        iterator->next->previous = iterator->previous;
+    }
+    else {
+        t->tail = iterator->previous;
+    }
+
+    t->activePlayers--;
+
+    return iterator;
+}
+
+// Helper function
+// Links the chain first..last of count players in at the front or back.
+static inline void team_bulk_link(team_t* t, int count, player_t* first, player_t* last, int atFront) {
+
+    // indexed and skip listed teams take the players one push at a time so
+    // their bookkeeping sees the usual end pushes
+    if (t->index != NULL || t->skip != NULL) {
+        player_t* p = atFront ? last : first;
+        while (p != NULL) {
+            player_t* following = atFront ? p->previous : p->next;
+            if (atFront) {
+                p->previous = NULL;
+                p->next = t->head;
+                if (t->head != NULL) {
+                    t->head->previous = p;
+                }
+                t->head = p;
+                if (t->tail == NULL) {
+                    t->tail = p;
+                }
+            }
+            else {
+                p->next = NULL;
+                p->previous = t->tail;
+                if (t->tail != NULL) {
+                    t->tail->next = p;
+                }
+                t->tail = p;
+                if (t->head == NULL) {
+                    t->head = p;
+                }
+            }
+            t->activePlayers++;
+            team_track_link(t, p);
+            p = following;
+        }
+        return;
+    }
+
+    if (t->activePlayers == 0) {
+        t->head = first;
+        t->tail = last;
+    }
+    else if (atFront) {
+        last->next = t->head;
+        t->head->previous = last;
+        t->head = first;
+        t->cursorPos += count;
+    }
+    else {
+        first->previous = t->tail;
+        t->tail->next = first;
+        t->tail = last;
+    }
+
+    t->activePlayers += count;
+}
+
+// Helper function
+// Adds count players at the front or back, see team_push_back_bulk.
+static inline int team_push_bulk(team_t* t, int count, int* rosters, char** names, int atFront) {
+
+    TEAM_STAT_OP(t, TEAM_OP_PUSH_BULK);
+    if (t == NULL) {
+        return -1;
+    }
+
+    if (count < 0 || (count > 0 && (rosters == NULL || names == NULL))) {
+        return 0;
+    }
+
+    if (t->sorted && count > 0) {
+        int i;
+        for (i = 1; i < count; i++) {
+            if (rosters[i] < rosters[i - 1]) {
+                return 0;
+            }
+        }
+        if (!team_sorted_fits(t, atFront ? 0 : t->activePlayers, rosters[0], rosters[count - 1])) {
+            return 0;
+        }
+    }
+
+    // other backends and small batches are not worth a block, interned
+    // names are shared one by one anyway
+    if (t->storage != TEAM_STORAGE_LINKED || count < TEAM_BULK_MIN || t->names != NULL) {
+        int i;
+        for (i = 0; i < count; i++) {
+            int at = atFront ? i : t->activePlayers;
+            int pushed = t->storage != TEAM_STORAGE_LINKED ?
+                         team_store_insert(t, at, rosters[i], names[i]) :
+                         team_insert(t, at, rosters[i], names[i]);
+            if (pushed != 1) {
+                // take back what this call added
+                for (; i > 0; i--) {
+                    free_player(atFront ? team_pop_front(t) : team_pop_back(t));
+                }
+                return 0;
+            }
+        }
+        return 1;
+    }
+
+    if (t->index != NULL && !team_index_reserve(t->index, count)) {
+        return 0;
+    }
+
+    player_t* first;
+    player_t* last;
+    if (!team_bulk_chain(t, count, rosters, names, NULL, &first, &last)) {
+        return 0;
+    }
+
+    team_bulk_link(t, count, first, last, atFront);
+
+    return 1;
+}
+
+// push count new players to the end of the team DLL, rosters[i] and
+// names[i] describing player i. All players and their long names are
+// allocated in one block and linked in one pass. On a sorted team the
+// rosters must be in order and fit after the last player.
+// Returns -1 if DLL is NULL.
+// Returns 1 on success
+// Returns 0 on failure, the team is left unchanged.
+static inline int team_push_back_bulk(team_t* t, int count, int* rosters, char** names){
+
+    return team_push_bulk(t, count, rosters, names, 0);
+}
+
+// push count new players to the front of the team DLL, keeping their order
+// so rosters[0] becomes the first player, see team_push_back_bulk.
+// Returns -1 if DLL is NULL.
+// Returns 1 on success
+// Returns 0 on failure, the team is left unchanged.
+static inline int team_push_front_bulk(team_t* t, int count, int* rosters, char** names){
+
+    return team_push_bulk(t, count, rosters, names, 1);
+}
+
+// Finds a player by roster number, in constant time on an indexed team,
+// in O(log n) on a sorted one and by scanning from the head otherwise.
+// The player stays on the team. With several players sharing the number
+// any one of them is returned. Unrolled and compact teams have no
+// player_t to point at, use team_remove_by_roster.
+// Returns NULL if the team is NULL or no player has that number.
+static inline player_t* team_find_by_roster(team_t* t, int roster){
+
+    TEAM_STAT_OP(t, TEAM_OP_FIND_BY_ROSTER);
+    if (t == NULL || t->storage != TEAM_STORAGE_LINKED) {
+        return NULL;
+    }
+
+    if (t->index != NULL) {
+        if (t->index->slots == NULL) {
+            return NULL;
+        }
+        unsigned int mask = (1u << t->index->bits) - 1;
+        unsigned int i = team_index_hash(t->index, roster);
+        while (t->index->slots[i] != NULL) {
+            if (t->index->slots[i]->rosterNum == roster) {
+                return t->index->slots[i];
+            }
+            i = (i + 1) & mask;
+            TEAM_STAT_HOPS(t, 1);
+        }
+        return NULL;
+    }
+
+    if (t->sorted) {
+        int pos;
+        player_t* found = team_sorted_seek(t, roster, 0, &pos);
+        return found != NULL && found->rosterNum == roster ? found : NULL;
+    }
+
+    player_t* iterator = t->head;
+    while (iterator != NULL && iterator->rosterNum != roster) {
+        iterator = iterator->next;
+        TEAM_STAT_HOPS(t, 1);
+    }
+
+    return iterator;
+}
+
+// Removes a player found by roster number, see team_find_by_roster.
+// Returns NULL if the list is NULL
+// Returns NULL on failure, i.e. no player has that number.
+static inline player_t* team_remove_by_roster(team_t* t, int roster){
+
+    TEAM_STAT_OP(t, TEAM_OP_REMOVE_BY_ROSTER);
+    if (t != NULL && t->storage != TEAM_STORAGE_LINKED) {
+        int pos = team_store_find(t, roster);
+        return pos < 0 ? NULL : team_store_remove(t, pos);
+    }
+
+    player_t* found = team_find_by_roster(t, roster);
+    if (found == NULL) {
+        return NULL;
+    }
+
+    team_track_unlink(t, found);
+    if (found->previous != NULL) {
+        found->previous->next = found->next;
+    }
+    else {
+        t->head = found->next;
+    }
+
+    if (found->next != NULL) {
+        found->next->previous = found->previous;
+    }
+    else {
+        t->tail = found->previous;
+    }
+
+    t->activePlayers--;
+
+    return found;
+}
+
+// Inserts a new player into a sorted team where its roster number keeps
+// the team in order, after any players with the same number. The place
+// is found down the skip list in O(log n).
+// Returns -1 if the list is NULL
+// Returns 1 on success
+// Returns 0 on failure, i.e. the team is not sorted or we could not
+// allocate memory.
+static inline int team_insert_sorted(team_t* t, int roster, char* name){
+
+    TEAM_STAT_OP(t, TEAM_OP_INSERT_SORTED);
+    if (t == NULL) {
+        return -1;
+    }
+
+    if (!t->sorted) {
+        return 0;
+    }
+
+    int pos;
+    player_t* before = team_sorted_seek(t, roster, 1, &pos);
+    player_t* newPlayer = team_new_player(t, roster, name);
+    if (newPlayer == NULL) {
+        return 0;
+    }
+
+    newPlayer->next = before;
+    newPlayer->previous = before != NULL ? before->previous : t->tail;
+    if (newPlayer->previous != NULL) {
+        newPlayer->previous->next = newPlayer;
+    }
+    else {
+        t->head = newPlayer;
+    }
+    if (before != NULL) {
+        before->previous = newPlayer;
+    }
+    else {
+        t->tail = newPlayer;
+    }
+
+    t->activePlayers++;
+    team_track_link(t, newPlayer);
+    t->cursor = newPlayer;
+    t->cursorPos = pos;
+
+    return 1;
+}
+
+// Returns the position of the first player of a sorted team whose roster
+// number is roster or more, the team size if there is none, in O(log n).
+// Returns -1 if the team is NULL or not sorted.
+static inline int team_lower_bound(team_t* t, int roster){
+
+    TEAM_STAT_OP(t, TEAM_OP_LOWER_BOUND);
+    if (t == NULL || !t->sorted) {
+        return -1;
+    }
+
+    int pos;
+    team_sorted_seek(t, roster, 0, &pos);
+
+    return pos;
+}
+
+// Calls visit on each player of a sorted team numbered low up to high, in
+// order, until visit returns 0. The first one is found in O(log n), the
+// rest are the players that follow it. visit must not change the team.
+// Returns the number of players visited.
+// Returns -1 if the team is NULL or not sorted, or visit is NULL.
+static inline int team_range(team_t* t, int low, int high, int (*visit)(player_t* p, void* arg), void* arg){
+
+    TEAM_STAT_OP(t, TEAM_OP_LOWER_BOUND);
+    if (t == NULL || !t->sorted || visit == NULL) {
+        return -1;
+    }
+
+    int pos;
+    player_t* iterator = team_sorted_seek(t, low, 0, &pos);
+    int visited = 0;
+    while (iterator != NULL && iterator->rosterNum <= high) {
+        visited++;
+        if (!visit(iterator, arg)) {
+            break;
+        }
+        iterator = iterator->next;
+    }
+    TEAM_STAT_HOPS(t, visited);
+
+    return visited;
+}
+
+// Puts the cursor on the player at position pos of a linked team, or past
+// the last player when pos is the team size.
+// Returns -1 if the team or cursor is NULL.
+// Returns 1 on success
+// Returns 0 if pos is out of range or the team is not linked.
+static inline int team_cursor_at(team_t* t, int pos, team_cursor_t* c){
+
+    if (t == NULL || c == NULL) {
+        return -1;
+    }
+
+    if (pos < 0 || t->activePlayers < pos || t->storage != TEAM_STORAGE_LINKED) {
+        return 0;
+    }
+
+    c->team = t;
+    c->player = pos < t->activePlayers ? team_walk(t, pos) : NULL;
+    c->pos = pos;
+
+    return 1;
+}
+
+// Returns the player the cursor is on, which stays on the team.
+// Returns NULL if the cursor is NULL or past the last player.
+static inline player_t* team_cursor_player(team_cursor_t* c){
+
+    if (c == NULL) {
+        return NULL;
+    }
+
+    return c->player;
+}
+
+// Moves the cursor on to the next player, or past the last one.
+// Returns -1 if the cursor is NULL.
+// Returns 1 on success
+// Returns 0 if the cursor is already past the last player.
+static inline int team_cursor_next(team_cursor_t* c){
+
+    if (c == NULL) {
+        return -1;
+    }
+
+    if (c->player == NULL) {
+        return 0;
+    }
+
+    c->player = c->player->next;
+    c->pos++;
+
+    return 1;
+}
+
+// Moves the cursor back to the previous player, from past the end to the
+// last one.
+// Returns -1 if the cursor is NULL.
+// Returns 1 on success
+// Returns 0 if the cursor is on the first player or the team is empty.
+static inline int team_cursor_previous(team_cursor_t* c){
+
+    if (c == NULL) {
+        return -1;
+    }
+
+    player_t* previous = c->player != NULL ? c->player->previous : c->team->tail;
+    if (previous == NULL) {
+        return 0;
+    }
+
+    c->player = previous;
+    c->pos--;
+
+    return 1;
+}
+
+// Inserts a new player before the player the cursor is on, or at the back
+// when it is past the last one. The cursor stays on the same player. On a
+// sorted team the player must fit between its neighbours.
+// Returns -1 if the cursor is NULL.
+// Returns 1 on success
+// Returns 0 on failure
+static inline int team_cursor_insert(team_cursor_t* c, int roster, char* name){
+
+    team_t* t = c != NULL ? c->team : NULL;
+    TEAM_STAT_OP(t, TEAM_OP_CURSOR);
+    if (c == NULL) {
+        return -1;
+    }
+
+    player_t* after = c->player;
+    player_t* before = after != NULL ? after->previous : t->tail;
+    if (t->sorted && ((before != NULL && roster < before->rosterNum) ||
+                      (after != NULL && after->rosterNum < roster))) {
+        return 0;
+    }
+
+    if (after == NULL) {
+        if (team_push_back(t, roster, name) != 1) {
+            return 0;
+        }
+        c->pos++;
+        return 1;
+    }
+
+    player_t* newPlayer = team_new_player(t, roster, name);
+    if (newPlayer == NULL) {
+        return 0;
+    }
+
+    newPlayer->next = after;
+    newPlayer->previous = before;
+    after->previous = newPlayer;
+    if (before != NULL) {
+        before->next = newPlayer;
+    }
+    else {
+        t->head = newPlayer;
+    }
+
+    t->activePlayers++;
+    team_track_link(t, newPlayer);
+    t->cursor = newPlayer;
+    t->cursorPos = c->pos;
+    c->pos++;
+
+    return 1;
+}
+
+// Removes the player the cursor is on from the team and moves the cursor
+// on to the next player, or past the last one.
+// Returns the removed player, free it with free_player.
+// Returns NULL if the cursor is NULL or past the last player.
+static inline player_t* team_cursor_remove(team_cursor_t* c){
+
+    team_t* t = c != NULL ? c->team : NULL;
+    TEAM_STAT_OP(t, TEAM_OP_CURSOR);
+    if (c == NULL || c->player == NULL) {
+        return NULL;
+    }
+
+    player_t* removed = c->player;
+    team_track_unlink(t, removed);
+    if (removed->previous != NULL) {
+        removed->previous->next = removed->next;
+    }
+    else {
+        t->head = removed->next;
+    }
+
+    if (removed->next != NULL) {
+        removed->next->previous = removed->previous;
+    }
+    else {
+        t->tail = removed->previous;
+    }
+
+    t->activePlayers--;
+    c->player = removed->next;
+    removed->next = NULL;
+    removed->previous = NULL;
+
+    return removed;
+}
+
+// Moves every player of src into dst, before the player at position pos,
+// leaving src empty. Players, names and pools are kept as they are, only
+// the links change, so this takes O(1) after finding pos. Indexed and
+// skip listed teams also redo their bookkeeping for the players moved.
+// Both teams must use linked storage and the same pool and intern table,
+// if any. Only a sorted src whose players fit at pos can go into a sorted
+// dst.
+// Returns -1 if either team is NULL.
+// Returns 1 on success
+// Returns 0 on failure
+static inline int team_splice(team_t* dst, int pos, team_t* src){
+
+    TEAM_STAT_OP(dst, TEAM_OP_SPLICE);
+    if (dst == NULL || src == NULL) {
+        return -1;
+    }
+
+    if (dst == src || dst->storage != TEAM_STORAGE_LINKED ||
+        src->storage != TEAM_STORAGE_LINKED || dst->pool != src->pool ||
+        dst->names != src->names) {
+        return 0;
+    }
+
+    if (pos < 0 || dst->activePlayers < pos) {
+        return 0;
+    }
+
+    if (src->activePlayers == 0) {
+        return 1;
+    }
+
+    if (dst->sorted && (!src->sorted ||
+        !team_sorted_fits(dst, pos, src->head->rosterNum, src->tail->rosterNum))) {
+        return 0;
+    }
+
+    if (dst->index != NULL && !team_index_reserve(dst->index, src->activePlayers)) {
+        return 0;
+    }
+
+    // the towers of src cannot move along with their players
+    if (src->skip != NULL) {
+        team_skip_clear(src);
+    }
+
+    player_t* before = pos < dst->activePlayers ? team_walk(dst, pos) : NULL;
+    player_t* after = before != NULL ? before->previous : dst->tail;
+
+    src->head->previous = after;
+    src->tail->next = before;
+    if (after != NULL) {
+        after->next = src->head;
+    }
+    else {
+        dst->head = src->head;
+    }
+    if (before != NULL) {
+        before->previous = src->tail;
+    }
+    else {
+        dst->tail = src->tail;
+    }
+
+    if (dst->index != NULL || src->index != NULL) {
+        player_t* iterator;
+        for (iterator = src->head; iterator != before; iterator = iterator->next) {
+            if (src->index != NULL) {
+                team_index_drop(src->index, iterator);
+            }
+            if (dst->index != NULL) {
+                team_index_place(dst->index, iterator);
+                dst->index->used++;
+            }
+        }
+    }
+
+    dst->activePlayers += src->activePlayers;
+    src->activePlayers = 0;
+    src->head = NULL;
+    src->tail = NULL;
+    dst->cursor = NULL;
+    src->cursor = NULL;
+
+    if (dst->skip != NULL) {
+        team_skip_rebuild(dst);
+    }
+
+    return 1;
+}
+
+// Splits a team in two at position pos: t keeps the players before pos
+// and a new team with the same configuration gets the rest, in O(1) after
+// finding pos. The new team keeps the recycle limit of t. A pooled team
+// shares its pool with the new team, and a team using an intern table its
+// table. Indexed and skip listed teams also redo their bookkeeping for the
+// players moved.
+// Returns a pointer to the new team.
+// Returns NULL if t is NULL, pos is out of range, t does not use linked
+// storage or we could not allocate memory.
+static inline team_t* team_split(team_t* t, int pos){
+
+    TEAM_STAT_OP(t, TEAM_OP_SPLIT);
+    if (t == NULL || t->storage != TEAM_STORAGE_LINKED) {
+        return NULL;
+    }
+
+    if (pos < 0 || t->activePlayers < pos) {
+        return NULL;
+    }
+
+    team_config_t config;
+    config.flags = (t->index != NULL ? TEAM_INDEXED : 0) |
+                   (t->skip != NULL ? TEAM_SKIPLIST : 0) |
+                   (t->sorted ? TEAM_SORTED : 0);
+    team_t* rest = create_team_with(&config);
+    if (rest == NULL) {
+        return NULL;
+    }
+
+    int moving = t->activePlayers - pos;
+    if (rest->index != NULL && !team_index_reserve(rest->index, moving)) {
+        free_team(rest);
+        return NULL;
+    }
+
+    rest->pool = t->pool;
+    if (rest->pool != NULL) {
+        rest->pool->teams++;
+    }
+    rest->spareLimit = t->spareLimit;
+    rest->names = t->names;
+    if (rest->names != NULL) {
+        rest->names->users++;
+    }
+
+    if (moving == 0) {
+        return rest;
+    }
+
+    if (t->skip != NULL) {
+        team_skip_clear(t);
+    }
+
+    player_t* first = team_walk(t, pos);
+    rest->head = first;
+    rest->tail = t->tail;
+    t->tail = first->previous;
+    if (t->tail != NULL) {
+        t->tail->next = NULL;
+    }
+    else {
+        t->head = NULL;
+    }
+    first->previous = NULL;
+
+    if (t->index != NULL) {
+        player_t* iterator;
+        for (iterator = first; iterator != NULL; iterator = iterator->next) {
+            team_index_drop(t->index, iterator);
+            team_index_place(rest->index, iterator);
+            rest->index->used++;
+        }
+    }
+
+    t->activePlayers = pos;
+    rest->activePlayers = moving;
+    t->cursor = NULL;
+
+    if (t->skip != NULL) {
+        team_skip_rebuild(t);
+        team_skip_rebuild(rest);
+    }
+
+    return rest;
+}
+
+// Helper function
+// Returns 1 if the player with roster a and name aName sorts strictly
+// before the one with roster b and name bName under key, 0 otherwise.
+static inline int team_sort_before(int key, int a, char* aName, int b, char* bName) {
+
+    if (key == TEAM_SORT_ROSTER) {
+        return a < b;
+    }
+    return strcmp(aName, bName) < 0;
+}
+
+// Helper function
+// Merges two sorted runs, taking from a on ties. A run is a chain linked
+// both ways whose first player's previous points at its last player. The
+// previous links are set while each player is in cache for the compare
+// anyway, so the sorted team needs no pass of its own to fix them.
+// Returns the first player of the merged run.
+static inline player_t* team_sort_merge(player_t* a, player_t* b, int key) {
+
+    player_t* aLast = a->previous;
+    player_t* bLast = b->previous;
+    player_t* head = NULL;
+    player_t* last = NULL;
+    player_t** link = &head;
+    while (a != NULL && b != NULL) {
+        player_t* taken;
+        if (team_sort_before(key, b->rosterNum, b->name, a->rosterNum, a->name)) {
+            taken = b;
+            b = b->next;
+        }
+        else {
+            taken = a;
+            a = a->next;
+        }
+        *link = taken;
+        taken->previous = last;
+        last = taken;
+        link = &taken->next;
+    }
+
+    player_t* rest = a != NULL ? a : b;
+    *link = rest;
+    rest->previous = last;
+    head->previous = a != NULL ? aLast : bLast;
+
+    return head;
+}
+
+// Helper function
+// Merges two sorted chains of compact slots linked by next, taking from a
+// on ties.
+// Returns the first slot of the merged chain.
+static inline uint32_t team_sort_merge_slots(team_slots_t* slots, uint32_t a, uint32_t b, int key) {
+
+    uint32_t head = TEAM_NO_SLOT;
+    uint32_t* tail = &head;
+    while (a != TEAM_NO_SLOT && b != TEAM_NO_SLOT) {
+        if (team_sort_before(key, slots->rosterNums[b], slots->names[b],
+                             slots->rosterNums[a], slots->names[a])) {
+            *tail = b;
+            b = slots->next[b];
+        }
+        else {
+            *tail = a;
+            a = slots->next[a];
+        }
+        tail = &slots->next[*tail];
+    }
+    *tail = a != TEAM_NO_SLOT ? a : b;
+
+    return head;
+}
+
+// Helper function
+// Sorts the chain starting at first, linked by next, into one run, see
+// team_sort_merge. Each player is merged into a stack of sorted runs of
+// doubling length as soon as it is reached, so merges mostly work on
+// players that were just touched and are still in cache.
+// Returns the first player of the run, NULL for an empty chain.
+static inline player_t* team_sort_chain(player_t* first, int key) {
+
+    // run i holds players reached before those of every run below it, so
+    // it is always the left side of a merge
+    player_t* run[TEAM_SORT_RUNS];
+    int runs = 0;
+    int i;
+    player_t* iterator = first;
+    while (iterator != NULL) {
+        player_t* carry = iterator;
+        iterator = iterator->next;
+        carry->next = NULL;
+        carry->previous = carry;
+        for (i = 0; i < runs && run[i] != NULL; i++) {
+            carry = team_sort_merge(run[i], carry, key);
+            run[i] = NULL;
+        }
+        if (i == runs) {
+            runs++;
+        }
+        run[i] = carry;
+    }
+
+    player_t* sorted = NULL;
+    for (i = 0; i < runs; i++) {
+        if (run[i] != NULL) {
+            sorted = sorted != NULL ? team_sort_merge(run[i], sorted, key) : run[i];
+        }
+    }
+
+    return sorted;
+}
+
+// Helper function
+// Sorts a compact team on its slot links the same way team_sort_chain
+// sorts a chain of players, then fixes up the previous links.
+static inline void team_sort_slots(team_t* t, int key) {
+
+    team_slots_t* slots = t->slots;
+    uint32_t run[TEAM_SORT_RUNS];
+    int runs = 0;
+    int i;
+    uint32_t slot = slots->head;
+    while (slot != TEAM_NO_SLOT) {
+        uint32_t carry = slot;
+        slot = slots->next[slot];
+        slots->next[carry] = TEAM_NO_SLOT;
+        for (i = 0; i < runs && run[i] != TEAM_NO_SLOT; i++) {
+            carry = team_sort_merge_slots(slots, run[i], carry, key);
+            run[i] = TEAM_NO_SLOT;
+        }
+        if (i == runs) {
+            runs++;
+        }
+        run[i] = carry;
+    }
+
+    uint32_t sorted = TEAM_NO_SLOT;
+    for (i = 0; i < runs; i++) {
+        if (run[i] != TEAM_NO_SLOT) {
+            sorted = team_sort_merge_slots(slots, run[i], sorted, key);
+        }
+    }
+
+    uint32_t previous = TEAM_NO_SLOT;
+    slots->head = sorted;
+    for (slot = sorted; slot != TEAM_NO_SLOT; slot = slots->next[slot]) {
+        slots->previous[slot] = previous;
+        previous = slot;
+    }
+    slots->tail = previous;
+    slots->cursor = TEAM_NO_SLOT;
+}
+
+// One player of an unrolled team while it is being sorted.
+typedef struct team_sort_entry {
+    int rosterNum;
+    char* name;
+} team_sort_entry_t;
+
+// Helper function
+// Sorts an unrolled team by copying its players out, merge sorting the
+// copies and writing them back over the same chunks.
+// Returns 1 on success
+// Returns 0 if we could not allocate memory.
+static inline int team_sort_chunks(team_t* t, int key) {
+
+    int n = t->activePlayers;
+    team_sort_entry_t* entries = (team_sort_entry_t*)malloc(sizeof(team_sort_entry_t) * 2 * (size_t)n);
+    if (entries == NULL) {
+        return n == 0;
+    }
+    team_sort_entry_t* from = entries;
+    team_sort_entry_t* to = entries + n;
+
+    team_chunk_t* chunk;
+    int i = 0;
+    for (chunk = t->firstChunk; chunk != NULL; chunk = chunk->next) {
+        int j;
+        for (j = 0; j < chunk->count; j++) {
+            from[i].rosterNum = chunk->rosterNums[j];
+            from[i].name = chunk->names[j];
+            i++;
+        }
+    }
+
+    int width;
+    for (width = 1; width < n; width *= 2) {
+        int left;
+        for (left = 0; left < n; left += 2 * width) {
+            int mid = left + width < n ? left + width : n;
+            int right = left + 2 * width < n ? left + 2 * width : n;
+            int a = left, b = mid, k = left;
+            while (a < mid && b < right) {
+                if (team_sort_before(key, from[b].rosterNum, from[b].name,
+                                     from[a].rosterNum, from[a].name)) {
+                    to[k++] = from[b++];
+                }
+                else {
+                    to[k++] = from[a++];
+                }
+            }
+            while (a < mid) {
+                to[k++] = from[a++];
+            }
+            while (b < right) {
+                to[k++] = from[b++];
+            }
+        }
+        team_sort_entry_t* swap = from;
+        from = to;
+        to = swap;
     }
 
-    t->activePlayers++;
-   
+    i = 0;
+    for (chunk = t->firstChunk; chunk != NULL; chunk = chunk->next) {
+        int j;
+        for (j = 0; j < chunk->count; j++) {
+            chunk->rosterNums[j] = from[i].rosterNum;
+            chunk->names[j] = from[i].name;
+            i++;
+        }
+    }
+
+    free(entries);
     return 1;
 }
 
-// push a new player to the end of the team DLL (after the last player in the list).
-// Returns -1 if DLL is NULL.
+// Sorts the team by key, TEAM_SORT_ROSTER or TEAM_SORT_NAME. The sort is
+// stable, players that compare equal keep their order. Linked and compact
+// teams are merge sorted bottom up on their own links without allocating,
+// see team_sort_chain. Skip listed teams relink the towers they have.
+// Unrolled teams sort copies of their players through a temporary buffer.
+// Returns -1 if the Team is NULL.
 // Returns 1 on success
-// Returns 0 on failure
-int team_push_back(team_t* t, int roster, char* name){
-	
+// Returns 0 on failure, i.e. an unknown key, sorting a sorted team by
+// name or no memory for the buffer.
+static inline int team_sort(team_t* t, int key){
+
+    TEAM_STAT_OP(t, TEAM_OP_SORT);
     if (t == NULL) {
         return -1;
     }
 
-    player_t* newPlayer = (player_t*)malloc(sizeof(player_t));
-    if (newPlayer == NULL) {
+    if (key != TEAM_SORT_ROSTER && key != TEAM_SORT_NAME) {
         return 0;
     }
-    newPlayer->rosterNum = roster;
 
-    int nameSize = strlen(name);
-    newPlayer->name = (char*)malloc(sizeof(char) * (nameSize+1));
-    if (newPlayer->name == NULL) {
-        return 0;
+    if (t->sorted) {
+        return key == TEAM_SORT_ROSTER;
     }
-    strcpy(newPlayer->name, name);
 
-    newPlayer->next = NULL;
-    newPlayer->previous = t->tail;
+    if (t->storage == TEAM_STORAGE_UNROLLED) {
+        return team_sort_chunks(t, key);
+    }
 
-    if (t->tail != NULL) {
-        t->tail->next = newPlayer;
+    if (t->storage == TEAM_STORAGE_COMPACT) {
+        team_sort_slots(t, key);
+        return 1;
     }
 
-    t->tail = newPlayer;
-    if (t->activePlayers == 0) {
-        t->head = newPlayer;
+    player_t* sorted = team_sort_chain(t->head, key);
+    TEAM_STAT_HOPS(t, t->activePlayers);
+
+    t->head = sorted;
+    t->tail = sorted != NULL ? sorted->previous : NULL;
+    if (sorted != NULL) {
+        sorted->previous = NULL;
     }
+    t->cursor = NULL;
 
-    t->activePlayers++;
+    if (t->skip != NULL) {
+        team_skip_relink(t);
+    }
 
     return 1;
 }
 
-// Returns the first player in the DLL and also removes it from the team.
-// Returns NULL if the Team is NULL. 
-// Returns NULL on failure, i.e. there is no one to pop from the team.
-player_t* team_pop_front(team_t* t){
+// Team Size
+// Returns -1 if the Team is NULL.
+// Queries the current size of a team
+static inline int team_size(team_t* t){
     
     if (t == NULL) {
-        return NULL;
-    }
-
-    if (t->activePlayers == 0) {
-        return NULL;
-    }
-
-    player_t* temp;
-    temp = t->head;
-    t->head = t->head->next;
-
-    if (t->activePlayers == 1) {
-        t->tail = NULL;
-    }
-    else {
-        t->head->previous = NULL;
+        return -1;
     }
-	
-    t->activePlayers--;
 
-    return temp;
+    return t->activePlayers;
 }
 
-// Returns the last player in the Team, and also removes it from the list.
-// Returns NULL if the Team is NULL. 
-// Returns NULL on failure.
-player_t* team_pop_back(team_t* t){
-    
-    if (t == NULL) {
-        return NULL;
-    }
-	
-    if (t->activePlayers == 0) {
-        return NULL;
-    }
+// Team Stats
+// Copies the operation counters of the team into stats. The counters are
+// only kept when the program is built with TEAM_STATS defined, otherwise
+// stats is zeroed.
+// Returns -1 if the Team or stats is NULL.
+// Returns 1 on success
+// Returns 0 if the counters are not built in.
+static inline int team_stats(team_t* t, team_stats_t* stats){
 
-    player_t* temp;
-    temp = t->tail;
-    t->tail = t->tail->previous;
-      
-    if (t->activePlayers == 1) {
-        t->head = NULL;
-    }
-    else {
-        t->tail->next = NULL;
+    if (t == NULL || stats == NULL) {
+        return -1;
     }
 
-    t->activePlayers--;
-    
-    return temp;
+#ifdef TEAM_STATS
+    *stats = *t->stats;
+    return 1;
+#else
+    memset(stats, 0, sizeof(team_stats_t));
+    return 0;
+#endif
 }
 
-// Inserts a new player before the player at the specified position.
-// Returns -1 if the list is NULL
+// Sets every operation counter of the team back to zero.
+// Returns -1 if the Team is NULL.
 // Returns 1 on success
-// Retruns 0 on failure:
-int team_insert(team_t* t, int pos, int roster, char* name){
-    
+// Returns 0 if the counters are not built in.
+static inline int team_stats_reset(team_t* t){
+
     if (t == NULL) {
         return -1;
     }
 
-    if (pos < 0 || t->activePlayers < pos) {
-        return 0;
-    }
+#ifdef TEAM_STATS
+    memset(t->stats, 0, sizeof(team_stats_t));
+    return 1;
+#else
+    return 0;
+#endif
+}
 
-    if (pos == t->activePlayers) {
-        team_push_back(t, roster, name);
-        return 1;
-    }
+// Hands a player taken off the team back for reuse instead of freeing it.
+// The next pushes take their player_t, and their name buffer when the
+// new name fits it, from the players kept this way, so a team whose size
+// stays about the same does not allocate or free at all. Once the team
+// keeps as many players as team_recycle_limit allows, or if the player
+// cannot be reused by this team (it is not linked, or p does not come
+// from the team's own pool), p is freed with free_player instead. p must
+// not be on any team.
+// Returns -1 if the team or player is NULL.
+// Returns 1 on success
+static inline int team_recycle_player(team_t* t, player_t* p){
 
-    player_t* newPlayer = (player_t*)malloc(sizeof(player_t));
-    if (newPlayer == NULL) {
-        return 0;
+    if (t == NULL || p == NULL) {
+        return -1;
     }
-    newPlayer->rosterNum = roster;
 
-    int nameSize = strlen(name);
-    newPlayer->name = (char*)malloc(sizeof(char) * (nameSize + 1));
-    if (newPlayer->name == NULL) {
-        return 0;
-    }
-    strcpy(newPlayer->name, name);
-    
-    player_t* iterator = t->head;
-    int i;
-    for (i=0; i<pos; i++) {
-        iterator = iterator->next;
+    // a reused player joins the team, and the players of a pooled team go
+    // with its pool without being visited, so they must all come from it
+    team_pool_t* pool = (p->flags & PLAYER_NODE_POOL) ? team_slab_of(p)->pool : NULL;
+    if (t->spareCount >= t->spareLimit || t->storage != TEAM_STORAGE_LINKED || pool != t->pool) {
+        free_player(p);
+        return 1;
     }
 
-    newPlayer->next = iterator;
-    if (t->activePlayers == 0) {
-        newPlayer->previous = NULL;
-        t->tail = newPlayer;
+    if (p->flags & PLAYER_NAME_INTERNED) {
+        team_names_release(p->name);
+        p->name = p->inlineName;
+        p->flags &= ~PLAYER_NAME_INTERNED;
     }
-    else {
-        newPlayer->previous = iterator->previous;
-        if (iterator->previous != NULL) {
-            iterator->previous->next = newPlayer;
-        }
-        iterator->previous = newPlayer;
+    if (p->name != p->inlineName) {
+        size_t capacity = strlen(p->name) + 1;
+        memcpy(p->inlineName, &capacity, sizeof(capacity));
     }
 
-    if (pos == 0) {
-        t->head = newPlayer;
-    }
+    p->next = t->spare;
+    t->spare = p;
+    t->spareCount++;
 
-    t->activePlayers++;
-        
     return 1;
 }
 
-// Returns the roster number of the player at position pos starting at 0 
-// Returns -1 if the list is NULL
-// Returns 0 on failure:
-int team_list_get(team_t* t, int pos){
-    
+// Sets how many players team_recycle_player keeps for reuse, freeing any
+// kept beyond the new limit. 0 turns recycling off.
+// Returns -1 if the team is NULL.
+// Returns 1 on success
+// Returns 0 if limit is negative.
+static inline int team_recycle_limit(team_t* t, int limit){
+
     if (t == NULL) {
         return -1;
     }
 
-    if (pos < 0 || t->activePlayers - 1 < pos) {
+    if (limit < 0) {
         return 0;
     }
 
-    player_t* iterator = t->head;
-    int i;
-    for (i=0; i<pos; i++) {
-        iterator = iterator->next;
+    t->spareLimit = limit;
+    while (t->spareCount > limit) {
+        player_t* p = t->spare;
+        t->spare = p->next;
+        t->spareCount--;
+        free_player(p);
     }
 
-    return iterator->rosterNum;
+    return 1;
 }
 
-// Removes the player at position pos starting at 0
-// Returns NULL if the list is NULL
-// Returns NULL on failure:
-player_t* team_list_remove(team_t* t, int pos){
-    
-    if (t == NULL) {
-        return NULL;
-    }
+// Creates an empty table of interned names, see team_names_t.
+// Returns a pointer to the new table.
+// Returns NULL if we could not allocate memory.
+static inline team_names_t* create_team_names(){
 
-    if (pos < 0 || t->activePlayers - 1 < pos) {
+    team_names_t* names = (team_names_t*)calloc(1, sizeof(team_names_t));
+    if (names == NULL) {
         return NULL;
     }
+    names->users = 1;
 
-    player_t* iterator = t->head;
-    int i;
-    for (i=0; i<pos; i++) {
-        iterator = iterator->next;
-    }
+    return names;
+}
 
-    if (iterator == NULL) {
-        return NULL;
-    }
+// Makes an empty linked team take the names of the players it creates
+// from now on out of names, which any number of teams can share. Every
+// push then stores a reference instead of a copy of the name, players
+// with the same name share one pointer, and the name is freed with the
+// last player using it. Players taken off a pooled team must still be
+// freed with free_player to give back their names.
+// Returns -1 if the team or table is NULL.
+// Returns 1 on success
+// Returns 0 on failure, i.e. the team has players, is not linked or
+// already uses a table.
+static inline int team_use_names(team_t* t, team_names_t* names){
 
-    if (iterator->previous != NULL) {
-        iterator->previous->next = iterator->next;
-    }
-    else {
-        t->head = iterator->next;
+    if (t == NULL || names == NULL) {
+        return -1;
     }
 
-    if (iterator->next != NULL) {
-        iterator->next->previous = iterator->previous;
+    if (t->activePlayers > 0 || t->storage != TEAM_STORAGE_LINKED || t->names != NULL) {
+        return 0;
     }
-    else {
-        t->tail = iterator->previous;
+
+    t->names = names;
+    names->users++;
+
+    return 1;
+}
+
+// Finds name in the table without taking a reference, so names of players
+// on teams using the table can be compared to it by pointer.
+// Returns the interned name.
+// Returns NULL if the table is NULL or does not hold name.
+static inline char* team_names_find(team_names_t* names, char* name){
+
+    if (names == NULL || name == NULL || names->bits == 0) {
+        return NULL;
     }
 
-    t->activePlayers--;
+    unsigned int hash = team_names_hash(name);
+    team_name_t* entry = names->buckets[hash & ((1u << names->bits) - 1)];
+    while (entry != NULL && (entry->hash != hash || strcmp(entry->text, name) != 0)) {
+        entry = entry->next;
+    }
 
-    return iterator;
+    return entry != NULL ? entry->text : NULL;
 }
 
-// Team Size
-// Returns -1 if the Team is NULL.
-// Queries the current size of a team
-int team_size(team_t* t){
-    
-    if (t == NULL) {
+// Returns the number of distinct names the table holds.
+// Returns -1 if the table is NULL.
+static inline int team_names_size(team_names_t* names){
+
+    if (names == NULL) {
         return -1;
     }
 
-    return t->activePlayers;
+    return names->count;
 }
 
 //Helper function
 //free_player(player_t* p)
 //Removes a play and its name from memory.
-void free_player(player_t* p) {
+//Always use this rather than free(), the name may live inside the player.
+//Pooled players go back to their team pool, so they must be freed before
+//the team they came from.
+static inline void free_player(player_t* p) {
     if (p == NULL) {
         return;
     }
-    
-    if (p->name != NULL) {
+
+    if (p->flags & PLAYER_NAME_INTERNED) {
+        team_names_release(p->name);
+    }
+    else if (p->name != NULL && p->name != p->inlineName &&
+        !(p->flags & PLAYER_NAME_ARENA)) {
         
         free(p->name);
     }
 
+    if (p->flags & PLAYER_NODE_POOL) {
+        team_pool_t* pool = team_slab_of(p)->pool;
+        p->next = pool->freePlayers;
+        pool->freePlayers = p;
+        return;
+    }
+
+    if (p->flags & PLAYER_NODE_BLOCK) {
+        team_slab_t* owner = team_slab_of(p)->owner;
+        // players of one block can be freed from several threads, see
+        // team_free_deferred
+        if (__atomic_sub_fetch(&owner->live, 1, __ATOMIC_ACQ_REL) == 0) {
+            team_slab_free(owner);
+        }
+        return;
+    }
+
     free(p);
 }
 
+// Helper function
+// Frees the chunks of an unrolled team and the names of a compact team,
+// leaving the chunk pointers and slot arrays for the caller to reset.
+static inline void team_free_unlinked(team_t* t) {
+
+    while (t->firstChunk != NULL) {
+        team_chunk_t* next = t->firstChunk->next;
+        int i;
+        for (i = 0; i < t->firstChunk->count; i++) {
+            free(t->firstChunk->names[i]);
+        }
+        free(t->firstChunk);
+        t->firstChunk = next;
+    }
+
+    if (t->slots != NULL) {
+        uint32_t slot;
+        for (slot = t->slots->head; slot != TEAM_NO_SLOT; slot = t->slots->next[slot]) {
+            free(t->slots->names[slot]);
+        }
+    }
+}
+
+// Removes and frees every player of the team, which stays usable with the
+// same configuration, intern table and recycle limit. A pooled team that
+// shares its pool with no other team gives all of its player and name
+// memory back in one free per slab allocation and name chunk, without
+// visiting the players unless they have skip list towers or interned
+// names. Players taken off such a team and not freed yet go with it, as
+// they do with free_team.
+// Returns -1 if the team is NULL.
+// Returns 1 on success
+static inline int team_clear(team_t* t){
+
+    if (t == NULL) {
+        return -1;
+    }
+
+    int limit = t->spareLimit;
+    team_recycle_limit(t, 0);
+    t->spareLimit = limit;
+
+    team_free_unlinked(t);
+    t->lastChunk = NULL;
+    t->cursorChunk = NULL;
+    t->cursorChunkPos = 0;
+
+    if (t->slots != NULL) {
+        team_slots_t* slots = t->slots;
+        slots->head = TEAM_NO_SLOT;
+        slots->tail = TEAM_NO_SLOT;
+        slots->cursor = TEAM_NO_SLOT;
+        slots->freeSlot = TEAM_NO_SLOT;
+        uint32_t i;
+        for (i = slots->capacity; i > 0; i--) {
+            slots->next[i - 1] = slots->freeSlot;
+            slots->freeSlot = i - 1;
+        }
+    }
+
+    if (t->index != NULL && t->index->slots != NULL) {
+        memset(t->index->slots, 0, sizeof(player_t*) << t->index->bits);
+        t->index->used = 0;
+    }
+
+    if (t->skip != NULL) {
+        team_skip_clear(t);
+    }
+
+    if (t->pool != NULL && t->pool->teams == 1) {
+        // the pool takes the players, but not their interned names
+        player_t* iterator;
+        for (iterator = t->names != NULL ? t->head : NULL; iterator != NULL; iterator = iterator->next) {
+            if (iterator->flags & PLAYER_NAME_INTERNED) {
+                team_names_release(iterator->name);
+            }
+        }
+        team_pool_reset(t->pool);
+    }
+    else {
+        player_t* iterator = t->head;
+        while (iterator != NULL) {
+            player_t* next = iterator->next;
+            free_player(iterator);
+            iterator = next;
+        }
+    }
+
+    t->head = NULL;
+    t->tail = NULL;
+    t->activePlayers = 0;
+    t->cursor = NULL;
+    t->cursorPos = 0;
+
+    return 1;
+}
+
 // Free Team DLL
 // Removes a Team and all of its players (...and their names!!...) from memory.
 // This should be called before the program terminates.
-void free_team(team_t* t){
+// A pooled team releases its slabs and name arena at once instead of
+// freeing player by player, once no other team shares the pool. See
+// team_free_deferred in my_dll_parallel.h to free a large unpooled team
+// off the calling thread.
+static inline void free_team(team_t* t){
     
     if (t == NULL) {
         return;
     }
 
+    team_recycle_limit(t, 0);
+    team_free_unlinked(t);
+
+    if (t->slots != NULL) {
+        free(t->slots->next);
+        free(t->slots->previous);
+        free(t->slots->rosterNums);
+        free(t->slots->names);
+        free(t->slots);
+    }
+
+    if (t->index != NULL) {
+        free(t->index->slots);
+        free(t->index);
+    }
+
+#ifdef TEAM_STATS
+    free(t->stats);
+#endif
+
+    if (t->skip != NULL) {
+        team_tower_t* tower = t->skip->header;
+        while (tower != NULL) {
+            team_tower_t* next = tower->height > 0 ? tower->lanes[0].next : NULL;
+            free(tower);
+            tower = next;
+        }
+        free(t->skip);
+    }
+
+    if (t->pool != NULL) {
+        // the pool takes the players, but not their interned names
+        player_t* iterator;
+        for (iterator = t->names != NULL ? t->head : NULL; iterator != NULL; iterator = iterator->next) {
+            if (iterator->flags & PLAYER_NAME_INTERNED) {
+                team_names_release(iterator->name);
+            }
+        }
+        if (t->names != NULL) {
+            t->names->users--;
+            team_names_check(t->names);
+        }
+        if (--t->pool->teams == 0) {
+            team_pool_free(t->pool);
+        }
+        free(t);
+        return;
+    }
+
     player_t* iterator = t->head;
     while (t->head != NULL) {
         iterator = iterator->next;
         free_player(t->head);
         t->head = iterator;
     }
+
+    if (t->names != NULL) {
+        t->names->users--;
+        team_names_check(t->names);
+    }
     
     free(t);
 }
 
+// Gives up the reference create_team_names returned. The table itself
+// stays until no team uses it and no player holds one of its names.
+static inline void free_team_names(team_names_t* names){
+
+    if (names == NULL) {
+        return;
+    }
+
+    names->users--;
+    team_names_check(names);
+}
 
+#ifdef __cplusplus
+}
+#endif
 
 #endif
@@ -0,0 +1,475 @@
+// ==================================================
+// Doubly Linked List for C++
+//
+// A doubly linked list template holding any payload, and a thin wrapper
+// to use the hockey team DLL of my_dll.h from C++.
+// ==================================================
+#ifndef MYDLL_HPP
+#define MYDLL_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "my_dll.h"
+
+namespace mydll {
+
+// Picks what a dll keeps track of besides its head. Without a count,
+// size() walks the list. Without a tail the list is singly ended:
+// emplace_back, pop_back and back() do not compile, and stepping back
+// from end() walks the list.
+template <bool Counted, bool Tail>
+struct dll_policy {
+    static constexpr bool counted = Counted;
+    static constexpr bool tail = Tail;
+};
+
+using counted_with_tail = dll_policy<true, true>;
+using uncounted_with_tail = dll_policy<false, true>;
+using counted_without_tail = dll_policy<true, false>;
+using uncounted_without_tail = dll_policy<false, false>;
+
+namespace detail {
+
+// One node of a dll, the payload is stored inline after the links.
+template <typename T>
+struct dll_node {
+    dll_node* next;
+    dll_node* previous;
+    T value;
+
+    template <typename... Args>
+    explicit dll_node(Args&&... args)
+        : next(nullptr), previous(nullptr), value(std::forward<Args>(args)...) {}
+};
+
+// The count of a counted dll, nothing for an uncounted one.
+template <bool Counted>
+struct dll_count {
+    std::size_t count = 0;
+};
+
+template <>
+struct dll_count<false> {};
+
+// The last node of a dll with a tail, nothing without one.
+template <typename Node, bool Tail>
+struct dll_tail {
+    Node* tail = nullptr;
+};
+
+template <typename Node>
+struct dll_tail<Node, false> {};
+
+// Allocator rebound to the nodes of a dll of T.
+template <typename T, typename Allocator>
+using dll_node_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<dll_node<T>>;
+
+}  // namespace detail
+
+// A doubly linked list of T, each element constructed in place in its own
+// node allocated from Allocator. Policy is a dll_policy, the bookkeeping
+// it leaves out costs nothing: the count and tail members are empty bases
+// and their upkeep is compiled out. A stateless allocator takes no room
+// either. The list owns its nodes, so it can be moved but not copied.
+template <typename T, typename Allocator = std::allocator<T>, typename Policy = counted_with_tail>
+class dll : private detail::dll_count<Policy::counted>,
+            private detail::dll_tail<detail::dll_node<T>, Policy::tail>,
+            private detail::dll_node_allocator<T, Allocator> {
+
+    using node = detail::dll_node<T>;
+    using node_allocator = detail::dll_node_allocator<T, Allocator>;
+    using node_traits = std::allocator_traits<node_allocator>;
+
+public:
+    using value_type = T;
+    using allocator_type = Allocator;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using policy = Policy;
+
+    // Bidirectional iterator, Constant picks the const_iterator.
+    template <bool Constant>
+    class basic_iterator {
+        friend class dll;
+        using owner_type = std::conditional_t<Constant, const dll*, dll*>;
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Constant, const T*, T*>;
+        using reference = std::conditional_t<Constant, const T&, T&>;
+
+        basic_iterator() : node_(nullptr), owner_(nullptr) {}
+
+        // an iterator converts to a const_iterator
+        template <bool WasConstant, typename = std::enable_if_t<Constant && !WasConstant>>
+        basic_iterator(const basic_iterator<WasConstant>& other) : node_(other.node_), owner_(other.owner_) {}
+
+        reference operator*() const { return node_->value; }
+        pointer operator->() const { return &node_->value; }
+
+        basic_iterator& operator++() {
+            node_ = node_->next;
+            return *this;
+        }
+
+        basic_iterator operator++(int) {
+            basic_iterator before = *this;
+            ++*this;
+            return before;
+        }
+
+        basic_iterator& operator--() {
+            node_ = node_ != nullptr ? node_->previous : owner_->last();
+            return *this;
+        }
+
+        basic_iterator operator--(int) {
+            basic_iterator before = *this;
+            --*this;
+            return before;
+        }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.node_ == b.node_; }
+        friend bool operator!=(const basic_iterator& a, const basic_iterator& b) { return a.node_ != b.node_; }
+
+    private:
+        template <bool>
+        friend class basic_iterator;
+
+        basic_iterator(node* n, owner_type owner) : node_(n), owner_(owner) {}
+
+        node* node_;		// nullptr for end()
+        owner_type owner_;	// list to find the last node in, for --end()
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    dll() noexcept(noexcept(node_allocator())) : node_allocator(), head_(nullptr) {}
+    explicit dll(const Allocator& alloc) : node_allocator(alloc), head_(nullptr) {}
+
+    dll(const dll&) = delete;
+    dll& operator=(const dll&) = delete;
+
+    dll(dll&& other) noexcept : node_allocator(std::move(other.alloc())), head_(nullptr) {
+        take(other);
+    }
+
+    dll& operator=(dll&& other) noexcept {
+        if (this != &other) {
+            clear();
+            alloc() = std::move(other.alloc());
+            take(other);
+        }
+        return *this;
+    }
+
+    ~dll() { clear(); }
+
+    // Constructs an element from args before the first one.
+    template <typename... Args>
+    reference emplace_front(Args&&... args) {
+        return link_before(head_, make(std::forward<Args>(args)...))->value;
+    }
+
+    // Constructs an element from args after the last one.
+    template <typename... Args>
+    reference emplace_back(Args&&... args) {
+        static_assert(Policy::tail, "emplace_back needs a dll with a tail");
+        return link_before(nullptr, make(std::forward<Args>(args)...))->value;
+    }
+
+    // Constructs an element from args before pos.
+    // Returns an iterator to it.
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+        return iterator(link_before(pos.node_, make(std::forward<Args>(args)...)), this);
+    }
+
+    // Destroys the first element, the list must not be empty.
+    void pop_front() { erase(begin()); }
+
+    // Destroys the last element, the list must not be empty.
+    void pop_back() {
+        static_assert(Policy::tail, "pop_back needs a dll with a tail");
+        erase(iterator(this->tail, this));
+    }
+
+    // Destroys the element at pos.
+    // Returns an iterator to the element that followed it.
+    iterator erase(const_iterator pos) {
+        node* n = pos.node_;
+        node* next = n->next;
+        if (n->previous != nullptr) {
+            n->previous->next = next;
+        }
+        else {
+            head_ = next;
+        }
+        if (next != nullptr) {
+            next->previous = n->previous;
+        }
+        if constexpr (Policy::tail) {
+            if (next == nullptr) {
+                this->tail = n->previous;
+            }
+        }
+        if constexpr (Policy::counted) {
+            this->count--;
+        }
+        destroy(n);
+        return iterator(next, this);
+    }
+
+    // Destroys every element.
+    void clear() noexcept {
+        while (head_ != nullptr) {
+            node* next = head_->next;
+            destroy(head_);
+            head_ = next;
+        }
+        if constexpr (Policy::tail) {
+            this->tail = nullptr;
+        }
+        if constexpr (Policy::counted) {
+            this->count = 0;
+        }
+    }
+
+    reference front() { return head_->value; }
+    const_reference front() const { return head_->value; }
+
+    reference back() {
+        static_assert(Policy::tail, "back needs a dll with a tail");
+        return this->tail->value;
+    }
+
+    const_reference back() const {
+        static_assert(Policy::tail, "back needs a dll with a tail");
+        return this->tail->value;
+    }
+
+    bool empty() const noexcept { return head_ == nullptr; }
+
+    // O(1) on a counted dll, a walk over the list otherwise.
+    size_type size() const noexcept {
+        if constexpr (Policy::counted) {
+            return this->count;
+        }
+        else {
+            size_type n = 0;
+            for (node* i = head_; i != nullptr; i = i->next) {
+                n++;
+            }
+            return n;
+        }
+    }
+
+    allocator_type get_allocator() const { return allocator_type(static_cast<const node_allocator&>(*this)); }
+
+    iterator begin() noexcept { return iterator(head_, this); }
+    iterator end() noexcept { return iterator(nullptr, this); }
+    const_iterator begin() const noexcept { return const_iterator(head_, this); }
+    const_iterator end() const noexcept { return const_iterator(nullptr, this); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+private:
+    node_allocator& alloc() noexcept { return *this; }
+
+    // Allocates a node and constructs its element from args.
+    template <typename... Args>
+    node* make(Args&&... args) {
+        node* n = node_traits::allocate(alloc(), 1);
+        try {
+            node_traits::construct(alloc(), n, std::forward<Args>(args)...);
+        }
+        catch (...) {
+            node_traits::deallocate(alloc(), n, 1);
+            throw;
+        }
+        return n;
+    }
+
+    void destroy(node* n) noexcept {
+        node_traits::destroy(alloc(), n);
+        node_traits::deallocate(alloc(), n, 1);
+    }
+
+    // Links n before next, nullptr meaning after the last node.
+    // Returns n.
+    node* link_before(node* next, node* n) noexcept {
+        n->next = next;
+        n->previous = next != nullptr ? next->previous : last();
+        if (n->previous != nullptr) {
+            n->previous->next = n;
+        }
+        else {
+            head_ = n;
+        }
+        if (next != nullptr) {
+            next->previous = n;
+        }
+        else if constexpr (Policy::tail) {
+            this->tail = n;
+        }
+        if constexpr (Policy::counted) {
+            this->count++;
+        }
+        return n;
+    }
+
+    // Returns the last node, walking there without a tail.
+    node* last() const noexcept {
+        if constexpr (Policy::tail) {
+            return this->tail;
+        }
+        else {
+            node* n = head_;
+            while (n != nullptr && n->next != nullptr) {
+                n = n->next;
+            }
+            return n;
+        }
+    }
+
+    // Takes the nodes of other, which must use an equal allocator.
+    void take(dll& other) noexcept {
+        head_ = other.head_;
+        other.head_ = nullptr;
+        if constexpr (Policy::tail) {
+            this->tail = other.tail;
+            other.tail = nullptr;
+        }
+        if constexpr (Policy::counted) {
+            this->count = other.count;
+            other.count = 0;
+        }
+    }
+
+    node* head_;
+};
+
+// The C team_t, owned and freed like a std::unique_ptr, with iterators
+// over the players of a linked team. Everything else is still the
+// team_* functions on get().
+class team {
+public:
+    // Bidirectional iterator over the players of a linked team.
+    class iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = player_t;
+        using difference_type = std::ptrdiff_t;
+        using pointer = player_t*;
+        using reference = player_t&;
+
+        iterator() : player_(nullptr), team_(nullptr) {}
+        iterator(player_t* p, team_t* t) : player_(p), team_(t) {}
+
+        reference operator*() const { return *player_; }
+        pointer operator->() const { return player_; }
+
+        iterator& operator++() {
+            player_ = player_->next;
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator before = *this;
+            player_ = player_->next;
+            return before;
+        }
+
+        iterator& operator--() {
+            player_ = player_ != nullptr ? player_->previous : team_->tail;
+            return *this;
+        }
+
+        iterator operator--(int) {
+            iterator before = *this;
+            --*this;
+            return before;
+        }
+
+        friend bool operator==(const iterator& a, const iterator& b) { return a.player_ == b.player_; }
+        friend bool operator!=(const iterator& a, const iterator& b) { return a.player_ != b.player_; }
+
+    private:
+        player_t* player_;	// nullptr for end()
+        team_t* team_;
+    };
+
+    // A player taken off the team, freed with free_player.
+    struct player_deleter {
+        void operator()(player_t* p) const { free_player(p); }
+    };
+    using player_ptr = std::unique_ptr<player_t, player_deleter>;
+
+    // Creates a team configured by config, see create_team_with. get()
+    // is nullptr if that failed.
+    explicit team(const team_config_t* config = nullptr) : team_(create_team_with(config)) {}
+
+    // Takes ownership of a team made by the C API.
+    explicit team(team_t* t) noexcept : team_(t) {}
+
+    team(const team&) = delete;
+    team& operator=(const team&) = delete;
+    team(team&& other) noexcept : team_(other.release()) {}
+
+    team& operator=(team&& other) noexcept {
+        if (this != &other) {
+            free_team(team_);
+            team_ = other.release();
+        }
+        return *this;
+    }
+
+    ~team() { free_team(team_); }
+
+    team_t* get() const noexcept { return team_; }
+
+    // Gives up ownership of the team.
+    team_t* release() noexcept {
+        team_t* t = team_;
+        team_ = nullptr;
+        return t;
+    }
+
+    // See team_push_front and team_push_back, the name is copied.
+    bool push_front(int roster, const char* name) { return team_push_front(team_, roster, const_cast<char*>(name)) == 1; }
+    bool push_back(int roster, const char* name) { return team_push_back(team_, roster, const_cast<char*>(name)) == 1; }
+
+    player_ptr pop_front() { return player_ptr(team_pop_front(team_)); }
+    player_ptr pop_back() { return player_ptr(team_pop_back(team_)); }
+
+    std::size_t size() const { return team_ != nullptr ? team_->activePlayers : 0; }
+    bool empty() const { return size() == 0; }
+
+    // Only linked teams have player_t nodes to iterate over, the range
+    // is empty for the others.
+    iterator begin() const { return iterator(team_ != nullptr ? team_->head : nullptr, team_); }
+    iterator end() const { return iterator(nullptr, team_); }
+
+private:
+    team_t* team_;
+};
+
+}  // namespace mydll
+
+#endif
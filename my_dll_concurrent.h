@@ -0,0 +1,1135 @@
+// ==================================================
+// Concurrent Doubly Linked Lists
+//
+// Thread safe variants of the hockey team DLL.
+//
+// Any number of files of a program can include the header, but the
+// hazard pointer registry is shared by every thread of the program, so
+// exactly one of them must define MYDLL_CONCURRENT_IMPLEMENTATION before
+// including it.
+// ==================================================
+#ifndef MYDLL_CONCURRENT_H
+#define MYDLL_CONCURRENT_H
+
+#include <pthread.h>
+#include <sched.h>
+#include "my_dll.h"
+
+// Threads that can use lock-free teams at the same time.
+#define TEAM_HAZARD_THREADS 128
+
+// Hazard pointers each thread may hold at once.
+#define TEAM_HAZARDS_PER_THREAD 2
+
+// Retired nodes a thread collects before scanning for ones it can free.
+#define TEAM_RETIRE_SCAN (2 * TEAM_HAZARD_THREADS * TEAM_HAZARDS_PER_THREAD)
+
+// Readers that can scan one read-copy-update team at the same time.
+#define TEAM_RCU_READERS 64
+
+// Players a read-copy-update team retires before trying to free them.
+#define TEAM_RCU_SCAN 64
+
+// define a struct for a team that many threads can use at once.
+// The team always starts with a dummy player that holds no payload, so
+// pushes at the back only ever touch the tail and pops at the front only
+// ever touch the head, and each end gets its own lock (the two-lock
+// queue of Michael and Scott). Work at the other ends is rarer and takes
+// both locks, head lock first.
+typedef struct team_concurrent {
+    player_t* head;		// the dummy player, the first real player is head->next.
+    player_t* tail;		// the last player, the dummy when the team is empty.
+    pthread_mutex_t headLock;	// guards head and pops at the front.
+    pthread_mutex_t tailLock;	// guards tail and pushes at the back.
+    int activePlayers;		// updated atomically, see team_concurrent_size.
+} team_concurrent_t;
+
+// Helper function
+// Moves the roster number and name of src over to dst, leaving src with
+// no name. Both must be unpooled players.
+static inline void player_move_payload(player_t* dst, player_t* src) {
+
+    dst->rosterNum = src->rosterNum;
+    if (src->name == src->inlineName) {
+        memcpy(dst->inlineName, src->inlineName, PLAYER_INLINE_NAME);
+        dst->name = dst->inlineName;
+    }
+    else {
+        dst->name = src->name;
+    }
+    src->name = NULL;
+}
+
+// Creates a concurrent Team
+// Returns a pointer to a newly created Team.
+// Returns NULL if we could not allocate memory.
+static inline team_concurrent_t* create_team_concurrent(){
+
+    team_concurrent_t* myTeam = (team_concurrent_t*)malloc(sizeof(team_concurrent_t));
+    if (myTeam == NULL) {
+        return NULL;
+    }
+
+    char noName[1] = "";
+    myTeam->head = create_player(0, noName);
+    if (myTeam->head == NULL) {
+        free(myTeam);
+        return NULL;
+    }
+    myTeam->head->name = NULL;
+    myTeam->tail = myTeam->head;
+    myTeam->activePlayers = 0;
+    pthread_mutex_init(&myTeam->headLock, NULL);
+    pthread_mutex_init(&myTeam->tailLock, NULL);
+
+    return myTeam;
+}
+
+// push a new player to the end of the concurrent team, only contending
+// with other pushes at the back.
+// Returns -1 if the team is NULL.
+// Returns 1 on success
+// Returns 0 on failure
+static inline int team_concurrent_push_back(team_concurrent_t* t, int roster, char* name){
+
+    if (t == NULL) {
+        return -1;
+    }
+
+    player_t* newPlayer = create_player(roster, name);
+    if (newPlayer == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&t->tailLock);
+    newPlayer->previous = t->tail;
+    // a pop at the front may be reading this link without the tail lock
+    __atomic_store_n(&t->tail->next, newPlayer, __ATOMIC_RELEASE);
+    t->tail = newPlayer;
+    __atomic_fetch_add(&t->activePlayers, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&t->tailLock);
+
+    return 1;
+}
+
+// push a new player to the front of the concurrent team, only contending
+// with other work at the front. The new player becomes the dummy and the
+// old dummy takes the payload, so the link a push at the back may be
+// writing is never touched.
+// Returns -1 if the team is NULL.
+// Returns 1 on success
+// Returns 0 on failure
+static inline int team_concurrent_push_front(team_concurrent_t* t, int roster, char* name){
+
+    if (t == NULL) {
+        return -1;
+    }
+
+    player_t* newPlayer = create_player(roster, name);
+    if (newPlayer == NULL) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&t->headLock);
+    player_t* oldDummy = t->head;
+    player_move_payload(oldDummy, newPlayer);
+    oldDummy->previous = newPlayer;
+    newPlayer->next = oldDummy;
+    t->head = newPlayer;
+    __atomic_fetch_add(&t->activePlayers, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&t->headLock);
+
+    return 1;
+}
+
+// Returns the first player of the concurrent team and also removes it,
+// only contending with other work at the front. The first player becomes
+// the new dummy and the old dummy carries its payload out.
+// Returns NULL if the team is NULL.
+// Returns NULL on failure, i.e. there is no one to pop from the team.
+static inline player_t* team_concurrent_pop_front(team_concurrent_t* t){
+
+    if (t == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&t->headLock);
+    player_t* oldDummy = t->head;
+    player_t* first = __atomic_load_n(&oldDummy->next, __ATOMIC_ACQUIRE);
+    if (first == NULL) {
+        pthread_mutex_unlock(&t->headLock);
+        return NULL;
+    }
+
+    player_move_payload(oldDummy, first);
+    first->previous = NULL;
+    t->head = first;
+    __atomic_fetch_sub(&t->activePlayers, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&t->headLock);
+
+    oldDummy->next = NULL;
+    oldDummy->previous = NULL;
+    return oldDummy;
+}
+
+// Returns the last player of the concurrent team and also removes it.
+// Takes both locks.
+// Returns NULL if the team is NULL.
+// Returns NULL on failure, i.e. there is no one to pop from the team.
+static inline player_t* team_concurrent_pop_back(team_concurrent_t* t){
+
+    if (t == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&t->headLock);
+    pthread_mutex_lock(&t->tailLock);
+    player_t* last = t->tail;
+    if (last == t->head) {
+        pthread_mutex_unlock(&t->tailLock);
+        pthread_mutex_unlock(&t->headLock);
+        return NULL;
+    }
+
+    t->tail = last->previous;
+    t->tail->next = NULL;
+    __atomic_fetch_sub(&t->activePlayers, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&t->tailLock);
+    pthread_mutex_unlock(&t->headLock);
+
+    last->previous = NULL;
+    return last;
+}
+
+// Returns the roster number of the player at position pos starting at 0.
+// Takes both locks.
+// Returns -1 if the list is NULL
+// Returns 0 on failure:
+static inline int team_concurrent_get(team_concurrent_t* t, int pos){
+
+    if (t == NULL) {
+        return -1;
+    }
+
+    int roster = 0;
+    pthread_mutex_lock(&t->headLock);
+    pthread_mutex_lock(&t->tailLock);
+    if (pos >= 0 && pos < t->activePlayers) {
+        player_t* iterator = t->head->next;
+        int i;
+        for (i = 0; i < pos; i++) {
+            iterator = iterator->next;
+        }
+        roster = iterator->rosterNum;
+    }
+    pthread_mutex_unlock(&t->tailLock);
+    pthread_mutex_unlock(&t->headLock);
+
+    return roster;
+}
+
+// Team Size
+// Returns -1 if the Team is NULL.
+// Queries the current size of a concurrent team, which may already be
+// out of date when other threads are pushing or popping.
+static inline int team_concurrent_size(team_concurrent_t* t){
+
+    if (t == NULL) {
+        return -1;
+    }
+
+    return __atomic_load_n(&t->activePlayers, __ATOMIC_RELAXED);
+}
+
+// Free concurrent Team
+// Removes a concurrent Team and all of its players from memory.
+// No other thread may be using the team.
+static inline void free_team_concurrent(team_concurrent_t* t){
+
+    if (t == NULL) {
+        return;
+    }
+
+    while (t->head != NULL) {
+        player_t* next = t->head->next;
+        free_player(t->head);
+        t->head = next;
+    }
+
+    pthread_mutex_destroy(&t->headLock);
+    pthread_mutex_destroy(&t->tailLock);
+    free(t);
+}
+
+
+// One link of a lock-free team. The players hang off links rather than
+// being linked themselves, so a popped player can be handed to the caller
+// while other threads may still be reading the link it came on.
+typedef struct team_link {
+    player_t* player;		// NULL in the dummy link.
+    struct team_link* next;
+} team_link_t;
+
+// A thread's hazard pointers: links it is about to read, which no other
+// thread may free, plus the links it unlinked and has yet to free.
+typedef struct team_hazard {
+    int taken;			// 1 while a live thread owns the record.
+    team_link_t* hazards[TEAM_HAZARDS_PER_THREAD];
+    team_link_t** retired;
+    int retiredCount;
+    int retiredSize;
+} team_hazard_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Hazard records shared by every lock-free team.
+extern team_hazard_t teamHazards[TEAM_HAZARD_THREADS];
+extern __thread team_hazard_t* teamMyHazard;
+extern pthread_key_t teamHazardKey;
+extern pthread_once_t teamHazardOnce;
+
+#ifdef MYDLL_CONCURRENT_IMPLEMENTATION
+team_hazard_t teamHazards[TEAM_HAZARD_THREADS];
+__thread team_hazard_t* teamMyHazard = NULL;
+pthread_key_t teamHazardKey;
+pthread_once_t teamHazardOnce = PTHREAD_ONCE_INIT;
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+// define a struct for a lock-free team, a Michael-Scott queue with
+// hazard pointer reclamation. Players are pushed at the back and popped
+// at the front by any number of threads without locks.
+typedef struct team_lockfree {
+    team_link_t* head;		// the dummy link, the first player is on head->next.
+    char pad[64 - sizeof(team_link_t*)];	// keeps head and tail on separate cache lines.
+    team_link_t* tail;		// the last link, or one behind it while a push finishes.
+    int activePlayers;		// updated atomically, see team_lockfree_size.
+} team_lockfree_t;
+
+// Helper function
+// Hands the hazard record of an exiting thread back, its retired links
+// go with it to the next thread taking the record.
+static inline void team_hazard_release(void* record) {
+
+    team_hazard_t* hazard = (team_hazard_t*)record;
+    int i;
+    for (i = 0; i < TEAM_HAZARDS_PER_THREAD; i++) {
+        __atomic_store_n(&hazard->hazards[i], NULL, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&hazard->taken, 0, __ATOMIC_RELEASE);
+}
+
+// Helper function
+static inline void team_hazard_key() {
+
+    pthread_key_create(&teamHazardKey, team_hazard_release);
+}
+
+// Helper function
+// Returns the hazard record of the calling thread, taking a free one on
+// first use.
+// Returns NULL if every record is taken.
+static inline team_hazard_t* team_hazard_mine() {
+
+    if (teamMyHazard != NULL) {
+        return teamMyHazard;
+    }
+
+    pthread_once(&teamHazardOnce, team_hazard_key);
+    int i;
+    for (i = 0; i < TEAM_HAZARD_THREADS; i++) {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&teamHazards[i].taken, &expected, 1, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            teamMyHazard = &teamHazards[i];
+            pthread_setspecific(teamHazardKey, teamMyHazard);
+            return teamMyHazard;
+        }
+    }
+
+    return NULL;
+}
+
+// Helper function
+// Publishes *from as hazard slot of the calling thread and returns it,
+// re-reading until the published pointer is still the current one.
+static inline team_link_t* team_hazard_protect(team_hazard_t* hazard, int slot, team_link_t** from) {
+
+    team_link_t* link = __atomic_load_n(from, __ATOMIC_ACQUIRE);
+    for (;;) {
+        __atomic_store_n(&hazard->hazards[slot], link, __ATOMIC_SEQ_CST);
+        team_link_t* again = __atomic_load_n(from, __ATOMIC_SEQ_CST);
+        if (again == link) {
+            return link;
+        }
+        link = again;
+    }
+}
+
+// Helper function
+// Frees every retired link of hazard that no thread holds a hazard on.
+static inline void team_hazard_scan(team_hazard_t* hazard) {
+
+    team_link_t* held[TEAM_HAZARD_THREADS * TEAM_HAZARDS_PER_THREAD];
+    int heldCount = 0;
+    int i, j;
+    for (i = 0; i < TEAM_HAZARD_THREADS; i++) {
+        for (j = 0; j < TEAM_HAZARDS_PER_THREAD; j++) {
+            team_link_t* link = __atomic_load_n(&teamHazards[i].hazards[j], __ATOMIC_SEQ_CST);
+            if (link != NULL) {
+                held[heldCount++] = link;
+            }
+        }
+    }
+
+    int kept = 0;
+    for (i = 0; i < hazard->retiredCount; i++) {
+        team_link_t* link = hazard->retired[i];
+        for (j = 0; j < heldCount && held[j] != link; j++) {
+        }
+        if (j < heldCount) {
+            hazard->retired[kept++] = link;
+        }
+        else {
+            free(link);
+        }
+    }
+    hazard->retiredCount = kept;
+}
+
+// Helper function
+// Frees link once no thread can be reading it any more.
+static inline void team_hazard_retire(team_hazard_t* hazard, team_link_t* link) {
+
+    if (hazard->retiredCount == hazard->retiredSize) {
+        int size = hazard->retiredSize > 0 ? 2 * hazard->retiredSize : TEAM_RETIRE_SCAN;
+        team_link_t** retired = (team_link_t**)realloc(hazard->retired, sizeof(team_link_t*) * size);
+        if (retired == NULL) {
+            // no room to defer it, so wait for the readers instead
+            team_hazard_scan(hazard);
+            while (hazard->retiredCount == hazard->retiredSize) {
+                sched_yield();
+                team_hazard_scan(hazard);
+            }
+        }
+        else {
+            hazard->retired = retired;
+            hazard->retiredSize = size;
+        }
+    }
+
+    hazard->retired[hazard->retiredCount++] = link;
+    if (hazard->retiredCount >= TEAM_RETIRE_SCAN) {
+        team_hazard_scan(hazard);
+    }
+}
+
+// Creates a lock-free Team
+// Returns a pointer to a newly created Team.
+// Returns NULL if we could not allocate memory.
+static inline team_lockfree_t* create_team_lockfree(){
+
+    team_lockfree_t* myTeam = (team_lockfree_t*)malloc(sizeof(team_lockfree_t));
+    if (myTeam == NULL) {
+        return NULL;
+    }
+
+    team_link_t* dummy = (team_link_t*)malloc(sizeof(team_link_t));
+    if (dummy == NULL) {
+        free(myTeam);
+        return NULL;
+    }
+    dummy->player = NULL;
+    dummy->next = NULL;
+    myTeam->head = dummy;
+    myTeam->tail = dummy;
+    myTeam->activePlayers = 0;
+
+    return myTeam;
+}
+
+// push a new player to the end of the lock-free team.
+// Returns -1 if the team is NULL.
+// Returns 1 on success
+// Returns 0 on failure, including more than TEAM_HAZARD_THREADS threads
+// using lock-free teams at once.
+static inline int team_lockfree_push_back(team_lockfree_t* t, int roster, char* name){
+
+    if (t == NULL) {
+        return -1;
+    }
+
+    team_hazard_t* hazard = team_hazard_mine();
+    if (hazard == NULL) {
+        return 0;
+    }
+
+    team_link_t* link = (team_link_t*)malloc(sizeof(team_link_t));
+    if (link == NULL) {
+        return 0;
+    }
+    link->player = create_player(roster, name);
+    if (link->player == NULL) {
+        free(link);
+        return 0;
+    }
+    link->next = NULL;
+
+    for (;;) {
+        team_link_t* tail = team_hazard_protect(hazard, 0, &t->tail);
+        team_link_t* next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+        if (next != NULL) {
+            // help a push that linked its player but not yet moved the tail
+            __atomic_compare_exchange_n(&t->tail, &tail, next, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+            continue;
+        }
+        if (__atomic_compare_exchange_n(&tail->next, &next, link, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            __atomic_compare_exchange_n(&t->tail, &tail, link, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+            break;
+        }
+    }
+
+    __atomic_store_n(&hazard->hazards[0], NULL, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&t->activePlayers, 1, __ATOMIC_RELAXED);
+
+    return 1;
+}
+
+// Returns the first player of the lock-free team and also removes it.
+// Returns NULL if the team is NULL.
+// Returns NULL on failure, i.e. there is no one to pop from the team, or
+// more than TEAM_HAZARD_THREADS threads are using lock-free teams at once.
+static inline player_t* team_lockfree_pop_front(team_lockfree_t* t){
+
+    if (t == NULL) {
+        return NULL;
+    }
+
+    team_hazard_t* hazard = team_hazard_mine();
+    if (hazard == NULL) {
+        return NULL;
+    }
+
+    player_t* player = NULL;
+    for (;;) {
+        team_link_t* head = team_hazard_protect(hazard, 0, &t->head);
+        team_link_t* next = team_hazard_protect(hazard, 1, &head->next);
+        if (__atomic_load_n(&t->head, __ATOMIC_ACQUIRE) != head) {
+            continue;
+        }
+        if (next == NULL) {
+            break;
+        }
+
+        team_link_t* tail = __atomic_load_n(&t->tail, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            // the tail lags behind a finished link, move it on first
+            __atomic_compare_exchange_n(&t->tail, &tail, next, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        if (__atomic_compare_exchange_n(&t->head, &head, next, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            // next is the new dummy, only the winner of the swap reads its player
+            player = next->player;
+            __atomic_store_n(&hazard->hazards[0], NULL, __ATOMIC_RELEASE);
+            __atomic_store_n(&hazard->hazards[1], NULL, __ATOMIC_RELEASE);
+            team_hazard_retire(hazard, head);
+            __atomic_fetch_sub(&t->activePlayers, 1, __ATOMIC_RELAXED);
+            return player;
+        }
+    }
+
+    __atomic_store_n(&hazard->hazards[0], NULL, __ATOMIC_RELEASE);
+    __atomic_store_n(&hazard->hazards[1], NULL, __ATOMIC_RELEASE);
+
+    return player;
+}
+
+// Team Size
+// Returns -1 if the Team is NULL.
+// Queries the current size of a lock-free team, which may already be out
+// of date when other threads are pushing or popping.
+static inline int team_lockfree_size(team_lockfree_t* t){
+
+    if (t == NULL) {
+        return -1;
+    }
+
+    return __atomic_load_n(&t->activePlayers, __ATOMIC_RELAXED);
+}
+
+// Free lock-free Team
+// Removes a lock-free Team and all of its players from memory.
+// No other thread may be using the team.
+static inline void free_team_lockfree(team_lockfree_t* t){
+
+    if (t == NULL) {
+        return;
+    }
+
+    // the dummy's player was handed out when it was popped
+    team_link_t* link = t->head;
+    while (link != NULL) {
+        team_link_t* next = link->next;
+        if (link != t->head) {
+            free_player(link->player);
+        }
+        free(link);
+        link = next;
+    }
+
+    free(t);
+}
+
+
+// One shard of a sharded team, a plain team with its own lock. Shards are
+// cache line aligned so owners working on neighbouring shards do not
+// bounce each other's locks around.
+typedef struct team_shard {
+    pthread_mutex_t lock;	// guards team.
+    team_t* team;
+    int activePlayers;		// updated atomically, lets thieves skip empty shards unlocked.
+} __attribute__((aligned(64))) team_shard_t;
+
+// define a struct for a sharded team used as a work queue by a fixed set
+// of workers. Each worker owns one shard and pushes and pops at its
+// front, so it mostly takes a lock nobody else wants. A worker whose
+// shard runs dry steals from the back of the other shards, taking the
+// oldest work and staying clear of the owner's end.
+typedef struct team_sharded {
+    team_shard_t* shards;
+    int shardCount;
+} team_sharded_t;
+
+// Creates a sharded Team with one shard per worker.
+// Returns a pointer to a newly created Team.
+// Returns NULL if shards is less than 1 or we could not allocate memory.
+static inline team_sharded_t* create_team_sharded(int shards){
+
+    if (shards < 1) {
+        return NULL;
+    }
+
+    team_sharded_t* myTeam = (team_sharded_t*)malloc(sizeof(team_sharded_t));
+    if (myTeam == NULL) {
+        return NULL;
+    }
+
+    myTeam->shards = (team_shard_t*)aligned_alloc(64, sizeof(team_shard_t) * shards);
+    if (myTeam->shards == NULL) {
+        free(myTeam);
+        return NULL;
+    }
+
+    int i;
+    for (i = 0; i < shards; i++) {
+        myTeam->shards[i].team = create_team();
+        if (myTeam->shards[i].team == NULL) {
+            while (i-- > 0) {
+                free_team(myTeam->shards[i].team);
+                pthread_mutex_destroy(&myTeam->shards[i].lock);
+            }
+            free(myTeam->shards);
+            free(myTeam);
+            return NULL;
+        }
+        myTeam->shards[i].activePlayers = 0;
+        pthread_mutex_init(&myTeam->shards[i].lock, NULL);
+    }
+    myTeam->shardCount = shards;
+
+    return myTeam;
+}
+
+// push a new player to the front of the shard owned by worker self.
+// Returns -1 if the team is NULL or self is not a shard.
+// Returns 1 on success
+// Returns 0 on failure
+static inline int team_sharded_push(team_sharded_t* t, int self, int roster, char* name){
+
+    if (t == NULL || self < 0 || self >= t->shardCount) {
+        return -1;
+    }
+
+    team_shard_t* shard = &t->shards[self];
+    pthread_mutex_lock(&shard->lock);
+    int pushed = team_push_front(shard->team, roster, name);
+    if (pushed == 1) {
+        __atomic_fetch_add(&shard->activePlayers, 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&shard->lock);
+
+    return pushed;
+}
+
+// Returns the last player of another worker's shard and also removes it.
+// Victims are tried round robin starting after the shard of self.
+// Returns NULL if the team is NULL or self is not a shard.
+// Returns NULL on failure, i.e. every other shard was empty when we
+// looked at it.
+static inline player_t* team_sharded_steal(team_sharded_t* t, int self){
+
+    if (t == NULL || self < 0 || self >= t->shardCount) {
+        return NULL;
+    }
+
+    int i;
+    for (i = 1; i < t->shardCount; i++) {
+        team_shard_t* victim = &t->shards[(self + i) % t->shardCount];
+        if (__atomic_load_n(&victim->activePlayers, __ATOMIC_RELAXED) == 0) {
+            continue;
+        }
+
+        pthread_mutex_lock(&victim->lock);
+        player_t* stolen = team_pop_back(victim->team);
+        if (stolen != NULL) {
+            __atomic_fetch_sub(&victim->activePlayers, 1, __ATOMIC_RELAXED);
+        }
+        pthread_mutex_unlock(&victim->lock);
+
+        if (stolen != NULL) {
+            return stolen;
+        }
+    }
+
+    return NULL;
+}
+
+// Returns the first player of the shard owned by worker self and also
+// removes it, stealing from the other shards once it is empty.
+// Returns NULL if the team is NULL or self is not a shard.
+// Returns NULL on failure, i.e. every shard was empty when we looked at it.
+static inline player_t* team_sharded_pop(team_sharded_t* t, int self){
+
+    if (t == NULL || self < 0 || self >= t->shardCount) {
+        return NULL;
+    }
+
+    team_shard_t* shard = &t->shards[self];
+    player_t* p = NULL;
+    if (__atomic_load_n(&shard->activePlayers, __ATOMIC_RELAXED) > 0) {
+        pthread_mutex_lock(&shard->lock);
+        p = team_pop_front(shard->team);
+        if (p != NULL) {
+            __atomic_fetch_sub(&shard->activePlayers, 1, __ATOMIC_RELAXED);
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+
+    if (p == NULL) {
+        p = team_sharded_steal(t, self);
+    }
+
+    return p;
+}
+
+// Team Size
+// Returns -1 if the Team is NULL.
+// Queries the number of players across all shards, which may already be
+// out of date when other threads are pushing or popping.
+static inline int team_sharded_size(team_sharded_t* t){
+
+    if (t == NULL) {
+        return -1;
+    }
+
+    int size = 0;
+    int i;
+    for (i = 0; i < t->shardCount; i++) {
+        size += __atomic_load_n(&t->shards[i].activePlayers, __ATOMIC_RELAXED);
+    }
+
+    return size;
+}
+
+// Free sharded Team
+// Removes a sharded Team and all of its players from memory.
+// No other thread may be using the team.
+static inline void free_team_sharded(team_sharded_t* t){
+
+    if (t == NULL) {
+        return;
+    }
+
+    int i;
+    for (i = 0; i < t->shardCount; i++) {
+        free_team(t->shards[i].team);
+        pthread_mutex_destroy(&t->shards[i].lock);
+    }
+
+    free(t->shards);
+    free(t);
+}
+
+
+// A reader slot of a read-copy-update team, holding the epoch its reader
+// started in or 0 when the slot is free.
+typedef struct team_rcu_reader {
+    unsigned long epoch;
+} __attribute__((aligned(64))) team_rcu_reader_t;
+
+// A player unlinked from a read-copy-update team, waiting for the readers
+// that may still see it.
+typedef struct team_rcu_retired {
+    player_t* player;
+    unsigned long epoch;	// epoch it was unlinked in.
+} team_rcu_retired_t;
+
+// define a struct for a team with read-copy-update style scans. Writers
+// take a lock and work on an ordinary linked team, publishing every link
+// change with a single release store, so readers can follow next pointers
+// from the head without any lock while writers carry on. Unlinked players
+// keep their next pointer and are only freed once every reader that
+// started before the unlink has finished.
+typedef struct team_rcu {
+    team_t* team;		// only touched by writers, readers only follow next.
+    pthread_mutex_t writeLock;	// serialises writers.
+    unsigned long epoch;	// bumped after every unlink, updated atomically.
+    team_rcu_reader_t readers[TEAM_RCU_READERS];
+    team_rcu_retired_t* retired;
+    int retiredCount;
+    int retiredSize;
+} team_rcu_t;
+
+// Creates a read-copy-update Team on top of a team made with config,
+// which must use linked storage and not be sorted.
+// Returns a pointer to a newly created Team.
+// Returns NULL if config asks for an unrolled, compact or sorted team or
+// we could not allocate memory.
+static inline team_rcu_t* create_team_rcu(const team_config_t* config){
+
+    if (config != NULL && (config->flags & (TEAM_UNROLLED | TEAM_COMPACT | TEAM_SORTED))) {
+        return NULL;
+    }
+
+    team_rcu_t* myTeam = (team_rcu_t*)aligned_alloc(64, sizeof(team_rcu_t));
+    if (myTeam == NULL) {
+        return NULL;
+    }
+
+    myTeam->team = create_team_with(config);
+    if (myTeam->team == NULL) {
+        free(myTeam);
+        return NULL;
+    }
+
+    int i;
+    for (i = 0; i < TEAM_RCU_READERS; i++) {
+        myTeam->readers[i].epoch = 0;
+    }
+    myTeam->epoch = 1;
+    myTeam->retired = NULL;
+    myTeam->retiredCount = 0;
+    myTeam->retiredSize = 0;
+    pthread_mutex_init(&myTeam->writeLock, NULL);
+
+    return myTeam;
+}
+
+// Helper function
+// Frees every retired player no reader can still see. A player unlinked
+// in epoch e is only visible to readers that started in epoch e or before.
+// The write lock must be held.
+static inline void team_rcu_reclaim(team_rcu_t* r) {
+
+    unsigned long oldest = __atomic_load_n(&r->epoch, __ATOMIC_SEQ_CST);
+    int i;
+    for (i = 0; i < TEAM_RCU_READERS; i++) {
+        unsigned long epoch = __atomic_load_n(&r->readers[i].epoch, __ATOMIC_SEQ_CST);
+        if (epoch != 0 && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+
+    int kept = 0;
+    for (i = 0; i < r->retiredCount; i++) {
+        if (r->retired[i].epoch < oldest) {
+            free_player(r->retired[i].player);
+        }
+        else {
+            r->retired[kept++] = r->retired[i];
+        }
+    }
+    r->retiredCount = kept;
+}
+
+// Helper function
+// Frees p once no reader can see it any more. The write lock must be held.
+static inline void team_rcu_retire(team_rcu_t* r, player_t* p) {
+
+    if (r->retiredCount == r->retiredSize) {
+        int size = r->retiredSize > 0 ? 2 * r->retiredSize : TEAM_RCU_SCAN;
+        team_rcu_retired_t* retired = (team_rcu_retired_t*)realloc(r->retired, sizeof(team_rcu_retired_t) * size);
+        if (retired == NULL) {
+            // no room to defer it, so wait for the readers instead
+            while (r->retiredCount == r->retiredSize) {
+                sched_yield();
+                team_rcu_reclaim(r);
+            }
+        }
+        else {
+            r->retired = retired;
+            r->retiredSize = size;
+        }
+    }
+
+    r->retired[r->retiredCount].player = p;
+    r->retired[r->retiredCount].epoch = __atomic_fetch_add(&r->epoch, 1, __ATOMIC_SEQ_CST);
+    r->retiredCount++;
+    if (r->retiredCount >= TEAM_RCU_SCAN) {
+        team_rcu_reclaim(r);
+    }
+}
+
+// Helper function
+// Links a new player in at position pos of the read-copy-update team,
+// which must be a valid position or the size of the team. Readers see
+// either the old chain or the new one, never a half linked player. The
+// write lock must be held.
+// Returns 1 on success
+// Returns 0 on failure
+static inline int team_rcu_link(team_rcu_t* r, int pos, int roster, char* name) {
+
+    team_t* t = r->team;
+    player_t* newPlayer = team_new_player(t, roster, name);
+    if (newPlayer == NULL) {
+        return 0;
+    }
+
+    player_t* following = pos < t->activePlayers ? team_walk(t, pos) : NULL;
+    player_t* before = following != NULL ? following->previous : t->tail;
+
+    // fill the new player in before any reader can reach it
+    newPlayer->next = following;
+    newPlayer->previous = before;
+    if (before != NULL) {
+        __atomic_store_n(&before->next, newPlayer, __ATOMIC_RELEASE);
+    }
+    else {
+        __atomic_store_n(&t->head, newPlayer, __ATOMIC_RELEASE);
+    }
+    if (following != NULL) {
+        following->previous = newPlayer;
+    }
+    else {
+        t->tail = newPlayer;
+    }
+
+    __atomic_store_n(&t->activePlayers, t->activePlayers + 1, __ATOMIC_RELAXED);
+    team_track_link(t, newPlayer);
+    t->cursor = newPlayer;
+    t->cursorPos = pos;
+
+    return 1;
+}
+
+// insert a new player to the read-copy-update team at position pos
+// starting at 0, pos may be the size of the team to push at the back.
+// Returns -1 if the team is NULL.
+// Returns 1 on success
+// Returns 0 on failure
+static inline int team_rcu_insert(team_rcu_t* r, int pos, int roster, char* name){
+
+    if (r == NULL) {
+        return -1;
+    }
+
+    int inserted = 0;
+    pthread_mutex_lock(&r->writeLock);
+    if (pos >= 0 && pos <= r->team->activePlayers) {
+        inserted = team_rcu_link(r, pos, roster, name);
+    }
+    pthread_mutex_unlock(&r->writeLock);
+
+    return inserted;
+}
+
+// push a new player to the end of the read-copy-update team.
+// Returns -1 if the team is NULL.
+// Returns 1 on success
+// Returns 0 on failure
+static inline int team_rcu_push_back(team_rcu_t* r, int roster, char* name){
+
+    if (r == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&r->writeLock);
+    int pushed = team_rcu_link(r, r->team->activePlayers, roster, name);
+    pthread_mutex_unlock(&r->writeLock);
+
+    return pushed;
+}
+
+// Removes the player at position pos starting at 0 from the
+// read-copy-update team. Readers already on the player carry on past it,
+// it is freed once they are all done.
+// Returns -1 if the team is NULL.
+// Returns 1 on success
+// Returns 0 on failure
+static inline int team_rcu_remove(team_rcu_t* r, int pos){
+
+    if (r == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&r->writeLock);
+    team_t* t = r->team;
+    if (pos < 0 || t->activePlayers - 1 < pos) {
+        pthread_mutex_unlock(&r->writeLock);
+        return 0;
+    }
+
+    player_t* iterator = team_walk(t, pos);
+    team_track_unlink(t, iterator);
+
+    // iterator keeps its next pointer for the readers still on it
+    if (iterator->previous != NULL) {
+        __atomic_store_n(&iterator->previous->next, iterator->next, __ATOMIC_RELEASE);
+    }
+    else {
+        __atomic_store_n(&t->head, iterator->next, __ATOMIC_RELEASE);
+    }
+    if (iterator->next != NULL) {
+        iterator->next->previous = iterator->previous;
+    }
+    else {
+        t->tail = iterator->previous;
+    }
+
+    __atomic_store_n(&t->activePlayers, t->activePlayers - 1, __ATOMIC_RELAXED);
+    team_rcu_retire(r, iterator);
+    pthread_mutex_unlock(&r->writeLock);
+
+    return 1;
+}
+
+// Starts a scan of the read-copy-update team. Every player reached from
+// team_rcu_first through team_rcu_next stays readable until the matching
+// team_rcu_read_end, and players on the team for the whole scan are all
+// seen in order. Writers are never blocked by a scan.
+// Returns the reader slot to hand to team_rcu_read_end.
+// Returns -1 if the team is NULL or TEAM_RCU_READERS scans are running.
+static inline int team_rcu_read_begin(team_rcu_t* r){
+
+    if (r == NULL) {
+        return -1;
+    }
+
+    int i;
+    for (i = 0; i < TEAM_RCU_READERS; i++) {
+        unsigned long epoch = __atomic_load_n(&r->epoch, __ATOMIC_SEQ_CST);
+        unsigned long expected = 0;
+        if (!__atomic_compare_exchange_n(&r->readers[i].epoch, &expected, epoch, 0,
+                                         __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            continue;
+        }
+
+        // a writer that bumped the epoch before our slot was visible may
+        // not have seen us, so start over in the newer epoch
+        unsigned long again = __atomic_load_n(&r->epoch, __ATOMIC_SEQ_CST);
+        while (again != epoch) {
+            epoch = again;
+            __atomic_store_n(&r->readers[i].epoch, epoch, __ATOMIC_SEQ_CST);
+            again = __atomic_load_n(&r->epoch, __ATOMIC_SEQ_CST);
+        }
+        return i;
+    }
+
+    return -1;
+}
+
+// Returns the first player of a running scan.
+// Returns NULL if the team is NULL or empty.
+static inline player_t* team_rcu_first(team_rcu_t* r){
+
+    if (r == NULL) {
+        return NULL;
+    }
+
+    return __atomic_load_n(&r->team->head, __ATOMIC_ACQUIRE);
+}
+
+// Returns the player after p in a running scan.
+// Returns NULL if p is NULL or the last player.
+static inline player_t* team_rcu_next(player_t* p){
+
+    if (p == NULL) {
+        return NULL;
+    }
+
+    return __atomic_load_n(&p->next, __ATOMIC_ACQUIRE);
+}
+
+// Ends the scan holding reader slot reader. No player of the scan may be
+// touched afterwards.
+static inline void team_rcu_read_end(team_rcu_t* r, int reader){
+
+    if (r == NULL || reader < 0 || reader >= TEAM_RCU_READERS) {
+        return;
+    }
+
+    __atomic_store_n(&r->readers[reader].epoch, 0, __ATOMIC_SEQ_CST);
+}
+
+// Waits until every scan running now has ended and frees all players
+// removed so far. Must not be called from inside a scan.
+// Returns -1 if the team is NULL.
+// Returns 1 on success
+static inline int team_rcu_synchronize(team_rcu_t* r){
+
+    if (r == NULL) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&r->writeLock);
+    team_rcu_reclaim(r);
+    while (r->retiredCount > 0) {
+        sched_yield();
+        team_rcu_reclaim(r);
+    }
+    pthread_mutex_unlock(&r->writeLock);
+
+    return 1;
+}
+
+// Team Size
+// Returns -1 if the Team is NULL.
+// Queries the current size of a read-copy-update team, which may already
+// be out of date when writers are at work.
+static inline int team_rcu_size(team_rcu_t* r){
+
+    if (r == NULL) {
+        return -1;
+    }
+
+    return __atomic_load_n(&r->team->activePlayers, __ATOMIC_RELAXED);
+}
+
+// Free read-copy-update Team
+// Removes a read-copy-update Team, its players and the removed players
+// still waiting for readers from memory. No other thread may be using the
+// team.
+static inline void free_team_rcu(team_rcu_t* r){
+
+    if (r == NULL) {
+        return;
+    }
+
+    int i;
+    for (i = 0; i < r->retiredCount; i++) {
+        free_player(r->retired[i].player);
+    }
+    free(r->retired);
+    free_team(r->team);
+    pthread_mutex_destroy(&r->writeLock);
+    free(r);
+}
+
+
+#endif
@@ -0,0 +1,548 @@
+// ==================================================
+// Doubly Linked List Files
+//
+// Save a hockey team DLL to a file and load it back, or stream it
+// through a file descriptor.
+// ==================================================
+#ifndef MYDLL_FILE_H
+#define MYDLL_FILE_H
+
+#include <stdio.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "my_dll.h"
+
+// First bytes of a team file, including the terminator.
+#define TEAM_FILE_MAGIC "DLLTEAM"
+
+// Layout version written by team_save.
+#define TEAM_FILE_VERSION 1
+
+// Rosters buffered by team_save per write.
+#define TEAM_FILE_BATCH 4096
+
+// First bytes of a team stream, including the terminator.
+#define TEAM_STREAM_MAGIC "DLLSTRM"
+
+// Layout version written by team_export.
+#define TEAM_STREAM_VERSION 1
+
+// Bytes team_export and team_import buffer at a time.
+#define TEAM_STREAM_BUFFER 65536
+
+// Longest name a team stream can carry, a record has to fit the buffer.
+#define TEAM_STREAM_NAME_MAX (TEAM_STREAM_BUFFER - 9)
+
+// Players team_import collects before appending them with one bulk push.
+#define TEAM_STREAM_BATCH 1024
+
+_Static_assert(sizeof(int) == sizeof(int32_t), "team files store rosters as int32_t");
+
+// Start of a team file. The header is followed by count int32_t roster
+// numbers and then nameBytes bytes of names, each with its terminator, in
+// team order. Everything is in host byte order, so files only move between
+// machines of the same endianness.
+typedef struct team_file_header {
+    char magic[8];		// TEAM_FILE_MAGIC
+    uint32_t version;		// TEAM_FILE_VERSION
+    uint32_t reserved;		// 0
+    uint64_t count;		// players
+    uint64_t nameBytes;		// bytes of names following the rosters
+} team_file_header_t;
+
+// Start of a team stream. It is followed by one record per player in team
+// order until the end of the stream: the roster number as an int32_t, the
+// name length as a uint32_t and the name without its terminator. Host
+// byte order, like team_file_header_t.
+typedef struct team_stream_header {
+    char magic[8];		// TEAM_STREAM_MAGIC
+    uint32_t version;		// TEAM_STREAM_VERSION
+    uint32_t reserved;		// 0
+} team_stream_header_t;
+
+// Buffers of one team_import call, which is all the memory it needs
+// besides the players themselves.
+typedef struct team_stream {
+    char buffer[TEAM_STREAM_BUFFER];	// bytes read, not parsed yet from start to end
+    size_t start;
+    size_t end;
+    int rosters[TEAM_STREAM_BATCH];	// players of the batch
+    char* names[TEAM_STREAM_BATCH];	// point into nameBytes
+    int count;
+    char nameBytes[TEAM_STREAM_BUFFER];	// names of the batch with terminators
+    size_t nameUsed;
+} team_stream_t;
+
+// A walk over the players of a team of any backend, in team order, see
+// team_file_next.
+typedef struct team_file_walk {
+    team_t* team;
+    int left;			// players not reached yet
+    player_t* player;		// next player of a linked team
+    team_chunk_t* chunk;	// chunk of the next player of an unrolled team
+    int offset;			// index of the next player in chunk
+    uint32_t slot;		// slot of the next player of a compact team
+} team_file_walk_t;
+
+// Helper function
+// Starts a walk over the players of t.
+static inline void team_file_walk_begin(team_file_walk_t* w, team_t* t) {
+
+    w->team = t;
+    w->left = t->activePlayers;
+    w->player = t->head;
+    w->chunk = t->firstChunk;
+    w->offset = 0;
+    w->slot = t->slots != NULL ? t->slots->head : TEAM_NO_SLOT;
+}
+
+// Helper function
+// Sets *roster and *name to those of the next player of a walk.
+// Returns 0 once every player was reached.
+static inline int team_file_next(team_file_walk_t* w, int* roster, char** name) {
+
+    if (w->left == 0) {
+        return 0;
+    }
+    w->left--;
+
+    if (w->team->storage == TEAM_STORAGE_UNROLLED) {
+        while (w->offset == w->chunk->count) {
+            w->chunk = w->chunk->next;
+            w->offset = 0;
+        }
+        *roster = w->chunk->rosterNums[w->offset];
+        *name = w->chunk->names[w->offset];
+        w->offset++;
+    }
+    else if (w->team->storage == TEAM_STORAGE_COMPACT) {
+        *roster = w->team->slots->rosterNums[w->slot];
+        *name = w->team->slots->names[w->slot];
+        w->slot = w->team->slots->next[w->slot];
+    }
+    else {
+        *roster = w->player->rosterNum;
+        *name = w->player->name;
+        w->player = w->player->next;
+    }
+
+    return 1;
+}
+
+// Helper function
+// Writes the roster numbers of every player to f in team order, or with
+// names set their names instead, or with f NULL just adds up the bytes
+// the names take.
+// Returns the bytes the names take with their terminators.
+// Returns -1 if a write failed.
+static inline long long team_save_part(team_t* t, FILE* f, int names) {
+
+    int32_t batch[TEAM_FILE_BATCH];
+    int used = 0;
+    long long nameBytes = 0;
+    team_file_walk_t w;
+    int roster;
+    char* name;
+
+    team_file_walk_begin(&w, t);
+    while (team_file_next(&w, &roster, &name)) {
+        size_t nameSize = strlen(name) + 1;
+        nameBytes += nameSize;
+        if (f == NULL) {
+            continue;
+        }
+        if (names) {
+            if (fwrite(name, 1, nameSize, f) != nameSize) {
+                return -1;
+            }
+            continue;
+        }
+        batch[used++] = roster;
+        if (used == TEAM_FILE_BATCH) {
+            if (fwrite(batch, sizeof(int32_t), used, f) != (size_t)used) {
+                return -1;
+            }
+            used = 0;
+        }
+    }
+
+    if (f != NULL && used > 0 && fwrite(batch, sizeof(int32_t), used, f) != (size_t)used) {
+        return -1;
+    }
+
+    return nameBytes;
+}
+
+// Writes every player of the team to the file at path in the layout of
+// team_file_header_t, replacing the file if it exists. Works for every
+// storage backend.
+// Returns -1 if the team or path is NULL.
+// Returns 1 on success
+// Returns 0 on failure, i.e. the file could not be written.
+static inline int team_save(team_t* t, const char* path){
+
+    if (t == NULL || path == NULL) {
+        return -1;
+    }
+
+    team_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TEAM_FILE_MAGIC, sizeof(header.magic));
+    header.version = TEAM_FILE_VERSION;
+    header.count = t->activePlayers;
+    header.nameBytes = team_save_part(t, NULL, 0);
+
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) {
+        return 0;
+    }
+
+    int saved = fwrite(&header, sizeof(header), 1, f) == 1 &&
+                team_save_part(t, f, 0) >= 0 &&
+                team_save_part(t, f, 1) >= 0;
+    if (fclose(f) != 0) {
+        saved = 0;
+    }
+
+    return saved;
+}
+
+// Helper function
+// Releases a mapping made by team_load, see team_slab_t.unmap.
+static inline void team_file_unmap(void* mapping, size_t size) {
+
+    munmap(mapping, size);
+}
+
+// Helper function
+// Checks that a mapped team file of size bytes is complete: the header
+// matches, the sizes add up and the names hold exactly count terminators,
+// the last one at the very end. Sorted teams also need the rosters in order.
+// Returns 1 if the file can be loaded into t.
+static inline int team_file_check(team_t* t, char* mapping, size_t size) {
+
+    team_file_header_t* header = (team_file_header_t*)mapping;
+    if (size < sizeof(team_file_header_t) ||
+        memcmp(header->magic, TEAM_FILE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != TEAM_FILE_VERSION || header->count > INT_MAX || header->nameBytes > size ||
+        size - sizeof(team_file_header_t) != header->count * sizeof(int32_t) + header->nameBytes) {
+        return 0;
+    }
+
+    char* names = mapping + sizeof(team_file_header_t) + header->count * sizeof(int32_t);
+    char* end = names + header->nameBytes;
+    uint64_t found = 0;
+    while (names < end) {
+        char* terminator = (char*)memchr(names, '\0', end - names);
+        if (terminator == NULL) {
+            return 0;
+        }
+        names = terminator + 1;
+        found++;
+    }
+    if (found != header->count) {
+        return 0;
+    }
+
+    int32_t* rosters = (int32_t*)(mapping + sizeof(team_file_header_t));
+    uint64_t i;
+    for (i = 1; t->sorted && i < header->count; i++) {
+        if (rosters[i] < rosters[i - 1]) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+// Creates a team configured by config, see create_team_with, holding the
+// players saved by team_save in the file at path. The file is mapped into
+// memory. A linked team gets every player node from a single bulk block,
+// with the names left where they are in the mapping instead of being
+// copied, so loading costs one pass over the file plus linking the
+// nodes. The mapping stays until the last of those players is freed, or
+// until the pool goes on a pooled team. Unrolled and compact teams keep
+// their own copies of the names, so they copy them and unmap the file.
+// Returns a pointer to the new team.
+// Returns NULL if path is NULL, the file cannot be read or is not a
+// complete team file, it is out of order for a sorted team, or we could
+// not allocate memory.
+static inline team_t* team_load(const char* path, const team_config_t* config){
+
+    if (path == NULL) {
+        return NULL;
+    }
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(team_file_header_t)) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = info.st_size;
+    int mapFlags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    mapFlags |= MAP_POPULATE;
+#endif
+    // writable so a name can still be changed in place, private so that
+    // copies the page instead of touching the file
+    char* mapping = (char*)mmap(NULL, size, PROT_READ | PROT_WRITE, mapFlags, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return NULL;
+    }
+
+    team_t* t = create_team_with(config);
+    if (t == NULL || !team_file_check(t, mapping, size)) {
+        free_team(t);
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    team_file_header_t* header = (team_file_header_t*)mapping;
+    int count = (int)header->count;
+    int* rosters = (int*)(mapping + sizeof(team_file_header_t));
+    char* names = mapping + sizeof(team_file_header_t) + header->count * sizeof(int32_t);
+
+    if (t->storage != TEAM_STORAGE_LINKED || count == 0) {
+        int i;
+        for (i = 0; i < count; i++) {
+            if (team_push_back(t, rosters[i], names) != 1) {
+                free_team(t);
+                munmap(mapping, size);
+                return NULL;
+            }
+            names += strlen(names) + 1;
+        }
+        munmap(mapping, size);
+        return t;
+    }
+
+    player_t* first;
+    player_t* last;
+    if ((t->index != NULL && !team_index_reserve(t->index, count)) ||
+        !team_bulk_chain(t, count, rosters, NULL, names, &first, &last)) {
+        free_team(t);
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    team_slab_t* block = team_slab_of(first)->owner;
+    block->mapping = mapping;
+    block->mappingSize = size;
+    block->unmap = team_file_unmap;
+    team_bulk_link(t, count, first, last, 0);
+
+    return t;
+}
+
+// Helper function
+// Writes size bytes to fd, however many write calls that takes.
+// Returns 1 on success
+// Returns 0 if a write failed.
+static inline int team_stream_write(int fd, char* bytes, size_t size) {
+
+    while (size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return 0;
+        }
+        bytes += written;
+        size -= written;
+    }
+
+    return 1;
+}
+
+// Writes every player of the team to fd as a team stream, see
+// team_stream_header_t, through one buffer of TEAM_STREAM_BUFFER bytes
+// whatever the team size. fd may be a pipe or socket, nothing is sought.
+// Works for every storage backend.
+// Returns -1 if the team is NULL or fd is negative.
+// Returns 1 on success
+// Returns 0 on failure, i.e. a write failed, a name is longer than
+// TEAM_STREAM_NAME_MAX or we could not allocate memory.
+static inline int team_export(team_t* t, int fd){
+
+    if (t == NULL || fd < 0) {
+        return -1;
+    }
+
+    char* buffer = (char*)malloc(TEAM_STREAM_BUFFER);
+    if (buffer == NULL) {
+        return 0;
+    }
+
+    team_stream_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TEAM_STREAM_MAGIC, sizeof(header.magic));
+    header.version = TEAM_STREAM_VERSION;
+    memcpy(buffer, &header, sizeof(header));
+    size_t used = sizeof(header);
+
+    team_file_walk_t w;
+    int roster;
+    char* name;
+    int exported = 1;
+    team_file_walk_begin(&w, t);
+    while (exported && team_file_next(&w, &roster, &name)) {
+        size_t length = strlen(name);
+        if (length > TEAM_STREAM_NAME_MAX) {
+            exported = 0;
+            break;
+        }
+        if (used + 8 + length > TEAM_STREAM_BUFFER) {
+            exported = team_stream_write(fd, buffer, used);
+            used = 0;
+        }
+        int32_t record[2] = {roster, (int32_t)length};
+        memcpy(buffer + used, record, 8);
+        memcpy(buffer + used + 8, name, length);
+        used += 8 + length;
+    }
+
+    if (exported) {
+        exported = team_stream_write(fd, buffer, used);
+    }
+    free(buffer);
+
+    return exported;
+}
+
+// Helper function
+// Reads from fd until at least size bytes are buffered, moving what is
+// left to the front of the buffer first.
+// Returns 1 once they are there.
+// Returns 0 if the stream ended before.
+// Returns -1 if a read failed.
+static inline int team_stream_need(team_stream_t* s, int fd, size_t size) {
+
+    if (s->end - s->start >= size) {
+        return 1;
+    }
+
+    memmove(s->buffer, s->buffer + s->start, s->end - s->start);
+    s->end -= s->start;
+    s->start = 0;
+    while (s->end < size) {
+        ssize_t got = read(fd, s->buffer + s->end, TEAM_STREAM_BUFFER - s->end);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return got == 0 ? 0 : -1;
+        }
+        s->end += got;
+    }
+
+    return 1;
+}
+
+// Helper function
+// Appends the players of the batch to t with one bulk push and empties it.
+// Returns 1 on success
+// Returns 0 on failure, see team_push_back_bulk.
+static inline int team_stream_flush(team_stream_t* s, team_t* t) {
+
+    int pushed = team_push_back_bulk(t, s->count, s->rosters, s->names);
+    s->count = 0;
+    s->nameUsed = 0;
+
+    return pushed == 1;
+}
+
+// Appends the players of a team stream read from fd, see team_export, to
+// the end of the team. Players are appended in batches of up to
+// TEAM_STREAM_BATCH with one bulk push each, so a linked team gets them a
+// block at a time, and the call needs the same fixed buffers whatever
+// the stream size. fd may be a pipe or socket, it is read to its end.
+// Returns -1 if the team is NULL or fd is negative.
+// Returns 1 on success
+// Returns 0 on failure, i.e. a read failed, the stream is not a complete
+// team stream, the players break the order of a sorted team or we could
+// not allocate memory. Players of the batches appended before stay on the
+// team.
+static inline int team_import(team_t* t, int fd){
+
+    if (t == NULL || fd < 0) {
+        return -1;
+    }
+
+    team_stream_t* s = (team_stream_t*)malloc(sizeof(team_stream_t));
+    if (s == NULL) {
+        return 0;
+    }
+    s->start = 0;
+    s->end = 0;
+    s->count = 0;
+    s->nameUsed = 0;
+
+    int imported = team_stream_need(s, fd, sizeof(team_stream_header_t)) == 1;
+    if (imported) {
+        team_stream_header_t header;
+        memcpy(&header, s->buffer, sizeof(header));
+        imported = memcmp(header.magic, TEAM_STREAM_MAGIC, sizeof(header.magic)) == 0 &&
+                   header.version == TEAM_STREAM_VERSION;
+        s->start = sizeof(header);
+    }
+
+    while (imported) {
+        int more = team_stream_need(s, fd, 8);
+        if (more == 0) {
+            // the stream may only end between records
+            imported = s->start == s->end;
+            break;
+        }
+        if (more < 0) {
+            imported = 0;
+            break;
+        }
+        int32_t record[2];
+        memcpy(record, s->buffer + s->start, 8);
+        if ((uint32_t)record[1] > TEAM_STREAM_NAME_MAX ||
+            team_stream_need(s, fd, 8 + (uint32_t)record[1]) != 1) {
+            imported = 0;
+            break;
+        }
+
+        size_t length = (uint32_t)record[1];
+        char* name = s->buffer + s->start + 8;
+        if (memchr(name, '\0', length) != NULL) {
+            imported = 0;
+            break;
+        }
+        if ((s->count == TEAM_STREAM_BATCH || s->nameUsed + length + 1 > TEAM_STREAM_BUFFER) &&
+            !team_stream_flush(s, t)) {
+            imported = 0;
+            break;
+        }
+
+        s->rosters[s->count] = record[0];
+        s->names[s->count] = s->nameBytes + s->nameUsed;
+        memcpy(s->names[s->count], name, length);
+        s->names[s->count][length] = '\0';
+        s->nameUsed += length + 1;
+        s->count++;
+        s->start += 8 + length;
+    }
+
+    if (imported && s->count > 0) {
+        imported = team_stream_flush(s, t);
+    }
+    free(s);
+
+    return imported;
+}
+
+#endif
@@ -0,0 +1,619 @@
+// ==================================================
+// Parallel Doubly Linked Lists
+//
+// Sorting and reductions over one hockey team DLL on several threads,
+// and freeing teams in the background.
+// ==================================================
+#ifndef MYDLL_PARALLEL_H
+#define MYDLL_PARALLEL_H
+
+#include <pthread.h>
+#include "my_dll.h"
+
+// Fewest players worth handing to a thread of their own.
+#define TEAM_PARALLEL_MIN 4096
+
+// Parts a reduction is cut into per thread, so threads finishing early
+// can pick up more work.
+#define TEAM_PARALLEL_PARTS 4
+
+// Work a team_workers_run call hands out, task is 0 to tasks - 1.
+typedef void (*team_task_t)(void* arg, int task);
+
+// define a struct for a pool of worker threads that run the tasks of one
+// team_workers_run call at a time, together with the calling thread.
+typedef struct team_workers {
+    pthread_t* threads;
+    int threadCount;		// worker threads, not counting the caller
+    pthread_mutex_t lock;	// guards everything below but the atomics
+    pthread_cond_t wake;	// signalled when a run starts or the pool stops
+    pthread_cond_t done;	// signalled when a worker leaves a run
+    unsigned long generation;	// bumped for every run
+    int stopping;
+    int busy;			// workers inside the current run
+    team_task_t task;
+    void* arg;
+    int tasks;
+    int nextTask;		// next task to hand out, updated atomically
+    int doneTasks;		// tasks finished, updated atomically
+} team_workers_t;
+
+// Helper function
+// Runs tasks of the current run until there are none left.
+static inline void team_workers_drain(team_workers_t* w) {
+
+    for (;;) {
+        int task = __atomic_fetch_add(&w->nextTask, 1, __ATOMIC_ACQ_REL);
+        if (task >= w->tasks) {
+            return;
+        }
+        w->task(w->arg, task);
+        __atomic_fetch_add(&w->doneTasks, 1, __ATOMIC_ACQ_REL);
+    }
+}
+
+// Helper function
+// Body of every worker thread: wait for a run, help with it, repeat.
+static inline void* team_workers_main(void* arg) {
+
+    team_workers_t* w = (team_workers_t*)arg;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&w->lock);
+    for (;;) {
+        while (w->generation == seen && !w->stopping) {
+            pthread_cond_wait(&w->wake, &w->lock);
+        }
+        if (w->stopping) {
+            break;
+        }
+        seen = w->generation;
+        w->busy++;
+        pthread_mutex_unlock(&w->lock);
+
+        team_workers_drain(w);
+
+        pthread_mutex_lock(&w->lock);
+        if (--w->busy == 0) {
+            pthread_cond_signal(&w->done);
+        }
+    }
+    pthread_mutex_unlock(&w->lock);
+
+    return NULL;
+}
+
+// Creates a pool of threads - 1 worker threads, the thread calling
+// team_workers_run makes up the last one.
+// Returns a pointer to the new pool.
+// Returns NULL if threads is less than 1 or we could not allocate memory
+// or start the threads.
+static inline team_workers_t* create_team_workers(int threads){
+
+    if (threads < 1) {
+        return NULL;
+    }
+
+    team_workers_t* w = (team_workers_t*)calloc(1, sizeof(team_workers_t));
+    if (w == NULL) {
+        return NULL;
+    }
+    w->threads = (pthread_t*)malloc(sizeof(pthread_t) * threads);
+    if (w->threads == NULL) {
+        free(w);
+        return NULL;
+    }
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->wake, NULL);
+    pthread_cond_init(&w->done, NULL);
+
+    for (w->threadCount = 0; w->threadCount < threads - 1; w->threadCount++) {
+        if (pthread_create(&w->threads[w->threadCount], NULL, team_workers_main, w) != 0) {
+            break;
+        }
+    }
+
+    return w;
+}
+
+// Returns the number of threads team_workers_run spreads tasks over,
+// counting the caller.
+// Returns -1 if the pool is NULL.
+static inline int team_workers_size(team_workers_t* w){
+
+    if (w == NULL) {
+        return -1;
+    }
+
+    return w->threadCount + 1;
+}
+
+// Runs task(arg, i) for every i from 0 to tasks - 1 on the pool and the
+// calling thread, and returns once all of them are done. A NULL pool runs
+// them all on the calling thread.
+static inline void team_workers_run(team_workers_t* w, int tasks, team_task_t task, void* arg){
+
+    if (w == NULL || w->threadCount == 0 || tasks <= 1) {
+        int i;
+        for (i = 0; i < tasks; i++) {
+            task(arg, i);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&w->lock);
+    // a worker that woke up too late for the last run may still be
+    // looking at its fields
+    while (w->busy > 0) {
+        pthread_cond_wait(&w->done, &w->lock);
+    }
+    w->task = task;
+    w->arg = arg;
+    w->tasks = tasks;
+    __atomic_store_n(&w->doneTasks, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&w->nextTask, 0, __ATOMIC_RELEASE);
+    w->generation++;
+    pthread_cond_broadcast(&w->wake);
+    pthread_mutex_unlock(&w->lock);
+
+    team_workers_drain(w);
+
+    // wait for the tasks still running, and for every worker to leave the
+    // run before its fields are reused
+    pthread_mutex_lock(&w->lock);
+    while (w->busy > 0 || __atomic_load_n(&w->doneTasks, __ATOMIC_ACQUIRE) < tasks) {
+        pthread_cond_wait(&w->done, &w->lock);
+    }
+    pthread_mutex_unlock(&w->lock);
+}
+
+// Free worker pool
+// Stops the worker threads and removes the pool from memory.
+static inline void free_team_workers(team_workers_t* w){
+
+    if (w == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&w->lock);
+    w->stopping = 1;
+    pthread_cond_broadcast(&w->wake);
+    pthread_mutex_unlock(&w->lock);
+
+    int i;
+    for (i = 0; i < w->threadCount; i++) {
+        pthread_join(w->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&w->lock);
+    pthread_cond_destroy(&w->wake);
+    pthread_cond_destroy(&w->done);
+    free(w->threads);
+    free(w);
+}
+
+// Helper function
+// Returns how many parts to cut a team of size players into for w, at
+// most wanted per thread and never fewer than TEAM_PARALLEL_MIN players
+// a part.
+static inline int team_parallel_parts(team_workers_t* w, int size, int wanted) {
+
+    long parts = (long)(w != NULL ? w->threadCount + 1 : 1) * wanted;
+    if (parts > size / TEAM_PARALLEL_MIN) {
+        parts = size / TEAM_PARALLEL_MIN;
+    }
+    return parts > 1 ? (int)parts : 1;
+}
+
+// Helper function
+// Cuts a linked team into parts runs of players as equal as possible,
+// setting first[i] to the first player of part i and counts[i] to its
+// size. Finds the cuts with the skip list when the team has one and by a
+// single walk of the chain otherwise.
+static inline void team_parallel_cut(team_t* t, int parts, player_t** first, int* counts) {
+
+    int i;
+    for (i = 0; i < parts; i++) {
+        counts[i] = t->activePlayers / parts + (i < t->activePlayers % parts);
+    }
+
+    if (t->skip != NULL) {
+        int pos = 0;
+        for (i = 0; i < parts; i++) {
+            first[i] = counts[i] > 0 ? team_skip_find(t, pos) : NULL;
+            pos += counts[i];
+        }
+        return;
+    }
+
+    player_t* iterator = t->head;
+    for (i = 0; i < parts; i++) {
+        first[i] = iterator;
+        int k;
+        for (k = 0; k < counts[i]; k++) {
+            iterator = iterator->next;
+        }
+    }
+}
+
+// Roster numbers of a team summed up by team_summarize_parallel.
+typedef struct team_summary {
+    long count;		// players
+    int min;		// smallest roster number, 0 if there are no players
+    int max;		// largest roster number, 0 if there are no players
+    long long sum;	// sum of the roster numbers
+} team_summary_t;
+
+// Shared state of a parallel reduction, each part fills in its own
+// summary and matches so no two threads write the same memory.
+typedef struct team_reduce {
+    player_t** first;
+    int* counts;
+    team_summary_t* summaries;
+    long* matches;
+    int (*predicate)(player_t* p, void* arg);	// NULL for a summary
+    void* predicateArg;
+} team_reduce_t;
+
+// Helper function
+// Reduces one part of a team, a task of team_workers_run.
+static inline void team_reduce_part(void* arg, int part) {
+
+    team_reduce_t* r = (team_reduce_t*)arg;
+    player_t* iterator = r->first[part];
+    int k;
+
+    if (r->predicate != NULL) {
+        long matches = 0;
+        for (k = 0; k < r->counts[part]; k++) {
+            matches += r->predicate(iterator, r->predicateArg) != 0;
+            iterator = iterator->next;
+        }
+        r->matches[part] = matches;
+        return;
+    }
+
+    team_summary_t summary;
+    summary.count = r->counts[part];
+    summary.min = iterator != NULL ? iterator->rosterNum : 0;
+    summary.max = summary.min;
+    summary.sum = 0;
+    for (k = 0; k < r->counts[part]; k++) {
+        int roster = iterator->rosterNum;
+        summary.min = roster < summary.min ? roster : summary.min;
+        summary.max = roster > summary.max ? roster : summary.max;
+        summary.sum += roster;
+        iterator = iterator->next;
+    }
+    r->summaries[part] = summary;
+}
+
+// Helper function
+// Cuts t into parts and runs the reduction r over them on w.
+// Returns the number of parts, or 0 if we could not allocate memory.
+static inline int team_reduce_run(team_workers_t* w, team_t* t, team_reduce_t* r) {
+
+    int parts = team_parallel_parts(w, t->activePlayers, TEAM_PARALLEL_PARTS);
+    r->first = (player_t**)malloc(sizeof(player_t*) * parts);
+    r->counts = (int*)malloc(sizeof(int) * parts);
+    r->summaries = (team_summary_t*)malloc(sizeof(team_summary_t) * parts);
+    r->matches = (long*)malloc(sizeof(long) * parts);
+    if (r->first == NULL || r->counts == NULL || r->summaries == NULL || r->matches == NULL) {
+        free(r->first);
+        free(r->counts);
+        free(r->summaries);
+        free(r->matches);
+        return 0;
+    }
+
+    team_parallel_cut(t, parts, r->first, r->counts);
+    team_workers_run(w, parts, team_reduce_part, r);
+
+    return parts;
+}
+
+// Sums up the roster numbers of a linked team on the pool w, which may be
+// NULL to do it all on the calling thread. No other thread may change the
+// team meanwhile.
+// Returns -1 if the Team or summary is NULL.
+// Returns 1 on success
+// Returns 0 on failure, i.e. the team is not linked or we could not
+// allocate memory.
+static inline int team_summarize_parallel(team_workers_t* w, team_t* t, team_summary_t* summary){
+
+    if (t == NULL || summary == NULL) {
+        return -1;
+    }
+
+    if (t->storage != TEAM_STORAGE_LINKED) {
+        return 0;
+    }
+
+    team_reduce_t r;
+    r.predicate = NULL;
+    int parts = team_reduce_run(w, t, &r);
+    if (parts == 0) {
+        return 0;
+    }
+
+    *summary = r.summaries[0];
+    int i;
+    for (i = 1; i < parts; i++) {
+        team_summary_t* part = &r.summaries[i];
+        if (part->count == 0) {
+            continue;
+        }
+        if (summary->count == 0 || part->min < summary->min) {
+            summary->min = part->min;
+        }
+        if (summary->count == 0 || part->max > summary->max) {
+            summary->max = part->max;
+        }
+        summary->count += part->count;
+        summary->sum += part->sum;
+    }
+
+    free(r.first);
+    free(r.counts);
+    free(r.summaries);
+    free(r.matches);
+    return 1;
+}
+
+// Counts the players of a linked team predicate returns non zero for, on
+// the pool w, which may be NULL to do it all on the calling thread.
+// predicate is called from several threads at once with arg. No other
+// thread may change the team meanwhile.
+// Returns -1 if the Team or predicate is NULL, the team is not linked or
+// we could not allocate memory.
+static inline long team_count_if_parallel(team_workers_t* w, team_t* t, int (*predicate)(player_t* p, void* arg), void* arg){
+
+    if (t == NULL || predicate == NULL || t->storage != TEAM_STORAGE_LINKED) {
+        return -1;
+    }
+
+    team_reduce_t r;
+    r.predicate = predicate;
+    r.predicateArg = arg;
+    int parts = team_reduce_run(w, t, &r);
+    if (parts == 0) {
+        return -1;
+    }
+
+    long matches = 0;
+    int i;
+    for (i = 0; i < parts; i++) {
+        matches += r.matches[i];
+    }
+
+    free(r.first);
+    free(r.counts);
+    free(r.summaries);
+    free(r.matches);
+    return matches;
+}
+
+// Shared state of a parallel sort: runs[i] is the sorted run of part i,
+// see team_sort_merge, and a merge round merges runs step apart.
+typedef struct team_psort {
+    player_t** runs;
+    int parts;
+    int step;
+    int key;
+} team_psort_t;
+
+// Helper function
+// Sorts one part into a run, a task of team_workers_run.
+static inline void team_psort_part(void* arg, int part) {
+
+    team_psort_t* s = (team_psort_t*)arg;
+    s->runs[part] = team_sort_chain(s->runs[part], s->key);
+}
+
+// Helper function
+// Merges run 2 * step * pair with the run step after it, a task of
+// team_workers_run.
+static inline void team_psort_merge(void* arg, int pair) {
+
+    team_psort_t* s = (team_psort_t*)arg;
+    int left = 2 * s->step * pair;
+    int right = left + s->step;
+    if (right < s->parts) {
+        s->runs[left] = team_sort_merge(s->runs[left], s->runs[right], s->key);
+    }
+}
+
+// Sorts a linked team like team_sort on the pool w, which may be NULL to
+// do it all on the calling thread. The chain is cut into one part per
+// thread, each part is sorted on its own, then neighbouring runs are
+// merged pairwise in rounds until one is left. The last round is a single
+// merge, so the sort scales with threads until that merge dominates. No
+// other thread may use the team meanwhile.
+// Returns -1 if the Team is NULL.
+// Returns 1 on success
+// Returns 0 on failure, i.e. an unknown key, the team is not linked or we
+// could not allocate memory.
+static inline int team_sort_parallel(team_workers_t* w, team_t* t, int key){
+
+    if (t == NULL) {
+        return -1;
+    }
+
+    if (t->storage != TEAM_STORAGE_LINKED || (key != TEAM_SORT_ROSTER && key != TEAM_SORT_NAME)) {
+        return 0;
+    }
+
+    // a sorted team has nothing to sort, or must refuse like team_sort
+    if (t->sorted) {
+        return team_sort(t, key);
+    }
+
+    team_psort_t s;
+    s.parts = team_parallel_parts(w, t->activePlayers, 1);
+    if (s.parts == 1) {
+        return team_sort(t, key);
+    }
+    s.key = key;
+    s.runs = (player_t**)malloc(sizeof(player_t*) * s.parts);
+    int* counts = (int*)malloc(sizeof(int) * s.parts);
+    if (s.runs == NULL || counts == NULL) {
+        free(s.runs);
+        free(counts);
+        return 0;
+    }
+
+    team_parallel_cut(t, s.parts, s.runs, counts);
+    // end every part's chain where the next part starts
+    int i;
+    for (i = 1; i < s.parts; i++) {
+        s.runs[i]->previous->next = NULL;
+    }
+    team_workers_run(w, s.parts, team_psort_part, &s);
+
+    for (s.step = 1; s.step < s.parts; s.step *= 2) {
+        int pairs = (s.parts + 2 * s.step - 1) / (2 * s.step);
+        team_workers_run(w, pairs, team_psort_merge, &s);
+    }
+
+    player_t* sorted = s.runs[0];
+    t->head = sorted;
+    t->tail = sorted->previous;
+    sorted->previous = NULL;
+    t->cursor = NULL;
+    if (t->skip != NULL) {
+        team_skip_relink(t);
+    }
+
+    free(s.runs);
+    free(counts);
+    return 1;
+}
+
+// A team waiting for the reaper thread.
+typedef struct team_reap {
+    struct team_reap* next;
+    team_t* team;
+} team_reap_t;
+
+// define a struct for a background thread that frees the teams handed to
+// team_free_deferred, so dropping a large unpooled team costs the caller
+// one queue push instead of two frees per player.
+typedef struct team_reaper {
+    pthread_t thread;
+    pthread_mutex_t lock;	// guards everything below
+    pthread_cond_t wake;	// signalled when a team is queued or the reaper stops
+    team_reap_t* first;		// teams waiting, oldest first
+    team_reap_t* last;
+    int stopping;
+} team_reaper_t;
+
+// Helper function
+// Body of the reaper thread: free queued teams until stopped with an
+// empty queue.
+static inline void* team_reaper_main(void* arg) {
+
+    team_reaper_t* r = (team_reaper_t*)arg;
+
+    pthread_mutex_lock(&r->lock);
+    for (;;) {
+        while (r->first == NULL && !r->stopping) {
+            pthread_cond_wait(&r->wake, &r->lock);
+        }
+        if (r->first == NULL) {
+            break;
+        }
+        team_reap_t* reap = r->first;
+        r->first = NULL;
+        r->last = NULL;
+        pthread_mutex_unlock(&r->lock);
+
+        while (reap != NULL) {
+            team_reap_t* next = reap->next;
+            free_team(reap->team);
+            free(reap);
+            reap = next;
+        }
+
+        pthread_mutex_lock(&r->lock);
+    }
+    pthread_mutex_unlock(&r->lock);
+
+    return NULL;
+}
+
+// Creates a reaper, a thread that frees teams for team_free_deferred.
+// Returns a pointer to the new reaper.
+// Returns NULL if we could not allocate memory or start the thread.
+static inline team_reaper_t* create_team_reaper(){
+
+    team_reaper_t* r = (team_reaper_t*)calloc(1, sizeof(team_reaper_t));
+    if (r == NULL) {
+        return NULL;
+    }
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->wake, NULL);
+
+    if (pthread_create(&r->thread, NULL, team_reaper_main, r) != 0) {
+        pthread_mutex_destroy(&r->lock);
+        pthread_cond_destroy(&r->wake);
+        free(r);
+        return NULL;
+    }
+
+    return r;
+}
+
+// Hands the team to the reaper thread, which frees it as free_team would.
+// The team must not be used again, nor share its pool or intern table
+// with a team still in use. A NULL reaper, or no memory to queue the
+// team, frees it on the calling thread.
+static inline void team_free_deferred(team_reaper_t* r, team_t* t){
+
+    if (t == NULL) {
+        return;
+    }
+
+    team_reap_t* reap = r != NULL ? (team_reap_t*)malloc(sizeof(team_reap_t)) : NULL;
+    if (reap == NULL) {
+        free_team(t);
+        return;
+    }
+    reap->next = NULL;
+    reap->team = t;
+
+    pthread_mutex_lock(&r->lock);
+    if (r->last != NULL) {
+        r->last->next = reap;
+    }
+    else {
+        r->first = reap;
+    }
+    r->last = reap;
+    pthread_cond_signal(&r->wake);
+    pthread_mutex_unlock(&r->lock);
+}
+
+// Free reaper
+// Waits for the reaper to free every team queued so far, stops its thread
+// and removes it from memory.
+static inline void free_team_reaper(team_reaper_t* r){
+
+    if (r == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&r->lock);
+    r->stopping = 1;
+    pthread_cond_signal(&r->wake);
+    pthread_mutex_unlock(&r->lock);
+
+    pthread_join(r->thread, NULL);
+
+    pthread_mutex_destroy(&r->lock);
+    pthread_cond_destroy(&r->wake);
+    free(r);
+}
+
+
+
+#endif